@@ -0,0 +1,254 @@
+/*
+ * ifshow_bench - Measures ifshow's grouping and formatting on synthetic interface tables.
+ * FR: ifshow_bench - Mesure le regroupement et le formatage d'ifshow sur des tables synthétiques.
+ *
+ * Build / Compilation (from the repository root):
+ *   gcc -Wall -Wextra -O2 -o ifshow_bench bench/ifshow_bench.c
+ *
+ * Usage / Utilisation:
+ * - ifshow_bench. EN: Run the 1k, 10k and 100k entry tables. FR: Lance les tables de 1k, 10k et 100k entrées.
+ * - ifshow_bench <entries> [<per_if>]. EN: One table of that size, <per_if> addresses per interface (default 8).
+ *   FR: Une table de cette taille, <per_if> adresses par interface (8 par défaut).
+ *
+ * The synthetic `ifaddrs` list goes through the same code as `ifshow -a` with the
+ * getifaddrs backend: walk_ifaddrs() into a snapshot and its grouping, then
+ * print_groups() into a memory-only output buffer. Allocations are counted by routing
+ * libifshow.c's realloc() through a counter.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+static size_t bench_allocs; // realloc() calls made by libifshow.c since the last reset
+
+/**
+ * @brief Counting wrapper installed in place of realloc() for libifshow.c.
+ */
+static void *bench_realloc(void *ptr, size_t size) {
+    bench_allocs++;
+    return realloc(ptr, size);
+}
+
+#define realloc(ptr, size) bench_realloc(ptr, size)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function" // internals the benchmark does not drive
+#include "../libifshow.c"
+#pragma GCC diagnostic pop
+#undef realloc
+
+/**
+ * @brief A synthetic `ifaddrs` list and the storage it points into.
+ */
+struct synth_table {
+    struct ifaddrs *entries;
+    struct sockaddr_in6 *addrs;     // large enough for either family
+    struct sockaddr_in6 *masks;
+    char (*names)[IF_NAMESIZE];
+    size_t count;
+    size_t ifaces;
+};
+
+/**
+ * @brief Fill a netmask sockaddr for a prefix length.
+ *
+ * @param sa      Storage to fill.
+ * @param family  AF_INET or AF_INET6.
+ * @param prefix  Prefix length.
+ */
+static void synth_mask(struct sockaddr_in6 *sa, int family, int prefix) {
+    memset(sa, 0, sizeof(*sa));
+    if (family == AF_INET) {
+        struct sockaddr_in *sin = (struct sockaddr_in *)sa;
+        sin->sin_family = AF_INET;
+        sin->sin_addr.s_addr = ipv4_mask(prefix);
+    } else {
+        sa->sin6_family = AF_INET6;
+        for (int i = 0; i < prefix; ++i) sa->sin6_addr.s6_addr[i / 8] |= (unsigned char)(0x80 >> (i % 8));
+    }
+}
+
+/**
+ * @brief Build a list shaped like a kernel dump: every IPv4 entry, then every IPv6 entry.
+ *
+ * Each interface gets `per_if` addresses, half IPv4 (a /24 then /32s) and half
+ * IPv6 (a /64 then /128s), so one interface's entries are far apart in the list.
+ *
+ * @param t        Table to build.
+ * @param entries  Total number of address entries.
+ * @param per_if   Addresses per interface (>= 1).
+ */
+static void synth_build(struct synth_table *t, size_t entries, size_t per_if) {
+    t->count = entries;
+    t->ifaces = (entries + per_if - 1) / per_if;
+    t->entries = calloc(entries, sizeof(*t->entries));
+    t->addrs = calloc(entries, sizeof(*t->addrs));
+    t->masks = calloc(entries, sizeof(*t->masks));
+    t->names = calloc(t->ifaces, sizeof(*t->names));
+    if (!t->entries || !t->addrs || !t->masks || !t->names) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < t->ifaces; ++i) snprintf(t->names[i], IF_NAMESIZE, "veth%05x", (unsigned int)(i & 0xfffff));
+
+    size_t v4_per_if = (per_if + 1) / 2;
+    size_t n = 0;
+    for (int pass = 0; pass < 2; ++pass) { // pass 0: IPv4, pass 1: IPv6
+        for (size_t k = 0; k < entries; ++k) {
+            size_t iface = k / per_if, slot = k % per_if;
+            int v6 = slot >= v4_per_if;
+            if (v6 != pass) continue;
+            struct ifaddrs *ifa = &t->entries[n];
+            struct sockaddr_in6 *sa = &t->addrs[n];
+            int first = slot == (v6 ? v4_per_if : 0);
+            if (!v6) {
+                struct sockaddr_in *sin = (struct sockaddr_in *)sa;
+                sin->sin_family = AF_INET;
+                sin->sin_addr.s_addr = htonl(0x0a000000u | (uint32_t)(iface << 8) | (uint32_t)(slot + 1));
+                synth_mask(&t->masks[n], AF_INET, first ? 24 : 32);
+            } else {
+                sa->sin6_family = AF_INET6;
+                sa->sin6_addr.s6_addr[0] = 0xfd;
+                sa->sin6_addr.s6_addr[4] = (unsigned char)(iface >> 16);
+                sa->sin6_addr.s6_addr[5] = (unsigned char)(iface >> 8);
+                sa->sin6_addr.s6_addr[6] = (unsigned char)iface;
+                sa->sin6_addr.s6_addr[15] = (unsigned char)(slot + 1);
+                synth_mask(&t->masks[n], AF_INET6, first ? 64 : 128);
+            }
+            ifa->ifa_name = t->names[iface];
+            ifa->ifa_addr = (struct sockaddr *)sa;
+            ifa->ifa_netmask = (struct sockaddr *)&t->masks[n];
+            ifa->ifa_next = n + 1 < entries ? &t->entries[n + 1] : NULL;
+            n++;
+        }
+    }
+}
+
+/**
+ * @brief Release a synthetic table.
+ */
+static void synth_free(struct synth_table *t) {
+    free(t->entries);
+    free(t->addrs);
+    free(t->masks);
+    free(t->names);
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Best-of-N timings and per-run allocation counts for one table.
+ */
+struct bench_result {
+    uint64_t group_ns, text_ns, json_ns;
+    size_t group_allocs, text_allocs, json_allocs;
+    size_t text_bytes, json_bytes;
+    size_t groups;
+};
+
+/**
+ * @brief Format a grouped snapshot with one printer into a fresh memory buffer.
+ *
+ * @param ops     Printer implementation.
+ * @param snap    Filled and grouped snapshot.
+ * @param ns      Receives the elapsed time.
+ * @param allocs  Receives the number of allocations.
+ * @return Number of bytes produced.
+ */
+static size_t bench_format(const struct printer_ops *ops, struct snapshot *snap, uint64_t *ns, size_t *allocs) {
+    struct outbuf ob = { .fd = -1 }; // memory only, never written out
+    struct printer p = { .ops = ops, .ob = &ob };
+    bench_allocs = 0;
+    uint64_t t0 = now_ns();
+    p.ops->begin(&p);
+    print_groups(&p, snap);
+    p.ops->end(&p);
+    *ns = now_ns() - t0;
+    *allocs = bench_allocs;
+    size_t bytes = ob.len;
+    free(ob.data);
+    return bytes;
+}
+
+/**
+ * @brief Run one table size `reps` times and keep the fastest run of each phase.
+ *
+ * @param t     Synthetic table.
+ * @param reps  Number of repetitions.
+ * @return Measurements.
+ */
+static struct bench_result bench_run(const struct synth_table *t, int reps) {
+    struct bench_result r = { .group_ns = UINT64_MAX, .text_ns = UINT64_MAX, .json_ns = UINT64_MAX };
+    for (int rep = 0; rep < reps; ++rep) {
+        struct snapshot snap = {0};
+        bench_allocs = 0;
+        uint64_t t0 = now_ns();
+        walk_ifaddrs(t->entries, NULL, snapshot_add, &snap);
+        snapshot_group(&snap);
+        uint64_t ns = now_ns() - t0;
+        if (ns < r.group_ns) r.group_ns = ns;
+        r.group_allocs = bench_allocs;
+        r.groups = snap.name_count;
+
+        ns = 0;
+        r.text_bytes = bench_format(&text_ops, &snap, &ns, &r.text_allocs);
+        if (ns < r.text_ns) r.text_ns = ns;
+        r.json_bytes = bench_format(&json_ops, &snap, &ns, &r.json_allocs);
+        if (ns < r.json_ns) r.json_ns = ns;
+        snapshot_free(&snap);
+    }
+    return r;
+}
+
+/**
+ * @brief Build, measure and report one table size.
+ *
+ * @param entries  Number of address entries.
+ * @param per_if   Addresses per interface.
+ */
+static void bench_size(size_t entries, size_t per_if) {
+    struct synth_table t;
+    synth_build(&t, entries, per_if);
+    int reps = entries <= 1000 ? 200 : entries <= 10000 ? 30 : 5;
+    struct bench_result r = bench_run(&t, reps);
+    if (r.groups != t.ifaces) fprintf(stderr, "ifshow_bench: expected %zu groups, got %zu\n", t.ifaces, r.groups);
+    double n = (double)entries;
+    printf("%9zu %8zu %10.1f %10.1f %10.1f %7zu %7zu %7zu %11zu\n", entries, t.ifaces,
+           r.group_ns / n, r.text_ns / n, r.json_ns / n,
+           r.group_allocs, r.text_allocs, r.json_allocs, r.text_bytes);
+    synth_free(&t);
+}
+
+/**
+ * @brief Benchmark entry point.
+ *
+ * @param argc  Argument count.
+ * @param argv  Optional table size and addresses per interface.
+ * @return `EXIT_SUCCESS`, or `EXIT_FAILURE` on invalid arguments.
+ */
+int main(int argc, char *argv[]) {
+    size_t per_if = 8;
+    if (argc > 3 || (argc > 1 && atol(argv[1]) <= 0) || (argc > 2 && atol(argv[2]) <= 0)) {
+        fprintf(stderr, "Usage: ifshow_bench [<entries> [<per_if>]]\n");
+        return EXIT_FAILURE;
+    }
+    if (argc > 2) per_if = (size_t)atol(argv[2]);
+
+    printf("%9s %8s %10s %10s %10s %7s %7s %7s %11s\n", "entries", "ifaces",
+           "group", "text", "json", "allocs", "allocs", "allocs", "text");
+    printf("%9s %8s %10s %10s %10s %7s %7s %7s %11s\n", "", "",
+           "ns/entry", "ns/entry", "ns/entry", "group", "text", "json", "bytes");
+    if (argc > 1) {
+        bench_size((size_t)atol(argv[1]), per_if);
+    } else {
+        const size_t sizes[] = { 1000, 10000, 100000 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) bench_size(sizes[i], per_if);
+    }
+    return EXIT_SUCCESS;
+}
@@ -2,225 +2,2548 @@
  * ifshow - Lists network interfaces and their IP addresses.
  * FR: ifshow - Liste les interfaces réseau et leurs adresses IP.
  *
+ * Command line on top of libifshow.a (enumeration, snapshots, printers; public API in ifshow.h,
+ * internals in libifshow_internal.h).
+ * FR: Ligne de commande au-dessus de libifshow.a (énumération, instantanés, formatage ; API publique dans ifshow.h,
+ * fonctions internes dans libifshow_internal.h).
+ *
+ * Build / Compilation (from the repository root):
+ *   gcc -Wall -Wextra -O2 -c libifshow.c && ar rcs libifshow.a libifshow.o
+ *   gcc -Wall -Wextra -O2 -pthread -o ifshow ifshow.c libifshow.a
+ *
  * Usage / Utilisation:
  * - ifshow -a. EN: Show all interfaces with IPv4/IPv6. FR: Affiche toutes les interfaces avec IPv4/IPv6.
  * - ifshow -i <name>. EN: Show only the specified interface. FR: Affiche uniquement l'interface spécifiée.
+ * - ifshow -i <a> -i <b> / -i <a>,<b>. EN: Show several interfaces, in that order, from one enumeration.
+ *   FR: Affiche plusieurs interfaces, dans cet ordre, à partir d'une seule énumération.
+ * - ifshow -i 'veth*' / -i 'eth[0-3]'. EN: Show every interface matching a glob (*, ?, [...]).
+ *   FR: Affiche toutes les interfaces correspondant à un motif glob (*, ?, [...]).
+ * - ifshow -w [-i <name>]. EN: Show, then print address additions/removals as they happen.
+ *   FR: Affiche, puis signale les ajouts/suppressions d'adresses au fil de l'eau.
+ * - ifshow --all-netns[=proc]. EN: Show every named (and with =proc, every process) network namespace.
+ *   FR: Affiche chaque espace de noms réseau nommé (et avec =proc, celui de chaque processus).
+ * - --json / --ndjson. EN: Machine-readable output (one document / one record per address).
+ *   FR: Sortie exploitable par machine (un document / un enregistrement par adresse).
+ * - --format=openmetrics. EN: Prometheus/OpenMetrics gauges per address (and counters with --stats).
+ *   FR: Jauges Prometheus/OpenMetrics par adresse (et compteurs avec --stats).
+ * - --output <file>. EN: Replace <file> atomically once the output is complete (textfile collectors).
+ *   FR: Remplace <file> de façon atomique une fois la sortie complète (collecteurs textfile).
+ * - ifshow --owner <ip>|-. EN: Print the interface owning each address (longest prefix; - reads stdin).
+ *   FR: Affiche l'interface propriétaire de chaque adresse (plus long préfixe ; - lit l'entrée standard).
+ * - -l. EN: Also print link flags, MTU and hardware address (same link dump as --stats).
+ *   FR: Affiche aussi les drapeaux, le MTU et l'adresse matérielle des liens (même dump que --stats).
+ * - --format=bin / --read <file>. EN: Write a compact binary document (string table + fixed-size records),
+ *   or print one back in any format. FR: Écrit un document binaire compact (table de chaînes + enregistrements
+ *   de taille fixe), ou en réaffiche un dans n'importe quel format.
+ * - --summarize. EN: Merge each interface's /32 and /128 hosts into the fewest prefixes they fill.
+ *   FR: Fusionne les hôtes /32 et /128 de chaque interface en un minimum de préfixes.
+ * - --stats / --rate <ms>. EN: Print link counters (one netlink dump) / per-second rates over <ms>.
+ *   FR: Affiche les compteurs des liens (un seul dump netlink) / les débits par seconde sur <ms>.
+ * - ifshow --count [-a|-i <name>]. EN: Print "<name> <ipv4> <ipv6>" address counts, nothing formatted.
+ *   FR: Affiche le nombre d'adresses "<nom> <ipv4> <ipv6>", sans rien formater.
+ * - ifshow --exists -i <name>. EN: Exit status only: 0 if the interface has an address.
+ *   FR: Code de sortie seul : 0 si l'interface a une adresse.
+ * - ifshow --wait -i <name> [--timeout <ms>]. EN: Block on address events until the interface has a matching address.
+ *   FR: Attend les événements d'adresse jusqu'à ce que l'interface ait une adresse correspondante.
+ * - ifshow --serve-stdin. EN: Answer show/owner/count/exists queries read from stdin, re-dumping only after address events.
+ *   FR: Répond aux requêtes show/owner/count/exists lues sur l'entrée standard, ne relit qu'après un événement d'adresse.
+ * - ifshow --daemon <socket> / ifshow -a --via <socket>. EN: Serve -a, pre-rendered and event-updated, on a unix socket / fetch it.
+ *   FR: Sert -a, pré-formaté et mis à jour par événements, sur une socket unix / le récupère.
+ * - ifshow --save <file> / --diff <file>. EN: Write a binary state file / print only the changes since one.
+ *   FR: Écrit un fichier d'état binaire / n'affiche que les changements depuis celui-ci.
+ * - -j <n>. EN: Format large snapshots on <n> threads (same output as without).
+ *   FR: Formate les gros instantanés sur <n> threads (même sortie que sans).
+ * - --sort=index|name|addr. EN: Sort interfaces and addresses for byte-comparable output.
+ *   FR: Trie interfaces et adresses pour une sortie comparable octet par octet.
+ * - --timings. EN: Report enumeration/grouping/formatting/output durations and counts on stderr.
+ *   FR: Affiche sur stderr les durées d'énumération/regroupement/formatage/écriture et les compteurs.
+ * - -4 / -6 / --scope=<list> / --in <cidr>. EN: Only show matching addresses (family, scope, network).
+ *   FR: N'affiche que les adresses correspondantes (famille, portée, réseau).
+ * - --backend=netlink|sysctl|getifaddrs. EN: Select the enumeration backend (netlink is the Linux default,
+ *   sysctl the BSD/macOS one). FR: Choisit le backend d'énumération (netlink par défaut sous Linux, sysctl sous BSD/macOS).
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // setns()
+#endif
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include "ifshow.h"
+#include "libifshow_internal.h" // linked from libifshow.a: the modes below also use the internals
+
+static enum backend backend = BACKEND_DEFAULT;
+
+/**
+ * @brief Name of the selected backend, as used in error messages.
+ */
+static const char *backend_name(void) {
+    return backend == BACKEND_NETLINK ? "netlink" : backend == BACKEND_SYSCTL ? "sysctl" : "getifaddrs";
+}
+
+/**
+ * @brief Monotonic clock in milliseconds.
+ */
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * @brief Durations and counts reported by --timings.
+ *
+ * Thread-local so --all-netns workers account for their own namespaces
+ * without locking; show_all_netns() adds theirs to the main thread's.
+ */
+struct timings {
+    double enumerate_ms;    // backend dumps (getifaddrs / netlink), link counter dumps included
+    double group_ms;        // sorting, grouping and summarizing snapshots
+    double format_ms;       // printers filling the output buffer
+    double output_ms;       // write(2) of the output buffer
+    size_t entries;         // addresses delivered by the backends, before filters
+    size_t interfaces;      // interface names in the snapshots
+    size_t addresses;       // addresses kept in the snapshots
+    size_t bytes;           // bytes written to stdout
+};
+
+static int timings_enabled;                 // --timings
+static _Thread_local struct timings timings;
+
+/**
+ * @brief Start timing a phase.
+ *
+ * @return Start time for timing_end(), 0 when --timings is off.
+ */
+static double timing_begin(void) {
+    return timings_enabled ? monotonic_ms() : 0;
+}
+
+/**
+ * @brief Add the time since timing_begin() to a phase.
+ *
+ * @param phase  Accumulator in `timings`.
+ * @param start  Value returned by timing_begin().
+ */
+static void timing_end(double *phase, double start) {
+    if (timings_enabled) *phase += monotonic_ms() - start;
+}
+
+/**
+ * @brief stdout_buf sink under --timings: write(2) to its descriptor, timed as output.
+ *
+ * @param data  Bytes to write.
+ * @param len   Number of bytes.
+ * @param arg   Descriptor (`int *`), read at each flush so --output can redirect it.
+ * @return 0 on success; -1 on write failure (errno set).
+ */
+static int timed_write(const void *data, size_t len, void *arg) {
+    int fd = *(const int *)arg;
+    double start = timing_begin();
+    size_t off = 0;
+    int rc = 0;
+    while (off < len) {
+        ssize_t n = write(fd, (const char *)data + off, len - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        off += (size_t)n;
+    }
+    timing_end(&timings.output_ms, start);
+    timings.bytes += off;
+    return rc;
+}
+
+static struct outbuf stdout_buf = { .fd = STDOUT_FILENO }; // every printer writes here
+
+/**
+ * @brief A file being replaced atomically: written as "<path>.tmp", renamed over `path` when complete.
+ */
+struct atomic_file {
+    const char *path;
+    char *tmp;      // "<path>.tmp"
+    int fd;         // open on `tmp`, -1 once committed or aborted
+};
+
+static struct atomic_file output_file = { .fd = -1 }; // --output: where stdout_buf goes instead of stdout
+
+/**
+ * @brief Create the temporary file next to `path`.
+ *
+ * Exits the process on failure.
+ *
+ * @param f     Receives the open file.
+ * @param path  File to replace.
+ */
+static void atomic_file_open(struct atomic_file *f, const char *path) {
+    size_t len = strlen(path);
+    f->path = path;
+    f->tmp = xrealloc(NULL, len + sizeof(".tmp"));
+    memcpy(f->tmp, path, len);
+    memcpy(f->tmp + len, ".tmp", sizeof(".tmp"));
+    f->fd = open(f->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (f->fd < 0) {
+        perror(f->tmp);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Drop the temporary file; `path` keeps its previous contents.
+ *
+ * @param f  Open file (no-op once committed or aborted).
+ */
+static void atomic_file_abort(struct atomic_file *f) {
+    if (f->fd < 0) return;
+    close(f->fd);
+    unlink(f->tmp);
+    f->fd = -1;
+    free(f->tmp);
+}
+
+/**
+ * @brief Make the written data durable, then rename it over `path`.
+ *
+ * Readers see either the old or the new file, never a partial one.
+ *
+ * @param f  Open file, everything written.
+ * @return 0 on success; -1 on failure (errno set, `perror` done, temporary file removed).
+ */
+static int atomic_file_commit(struct atomic_file *f) {
+    int failed = fsync(f->fd) != 0; // data on disk before the rename makes it visible
+    failed |= close(f->fd) != 0;
+    int rc = 0;
+    if (failed || rename(f->tmp, f->path) != 0) {
+        int saved = errno;
+        perror(failed ? f->tmp : f->path);
+        unlink(f->tmp);
+        errno = saved;
+        rc = -1;
+    }
+    f->fd = -1;
+    free(f->tmp);
+    return rc;
+}
+
+/**
+ * @brief atexit hook: write whatever stdout output is still pending.
+ *
+ * An --output file not committed by then belongs to a failed run and is dropped.
+ */
+static void flush_stdout_at_exit(void) {
+    out_flush(&stdout_buf);
+    atomic_file_abort(&output_file);
+}
+
+/**
+ * @brief Print CLI usage instructions to stdout.
+ *
+ * Describes available options and examples for using the program. Does not
+ * exit; callers decide flow control. Goes through the stdout buffer like
+ * every other printer.
+ */
+void help() {
+    struct outbuf *ob = &stdout_buf;
+    out_puts(ob, "Usage:\n");
+    out_puts(ob, "  ifshow -a                     # Show all interfaces\n");
+    out_puts(ob, "  ifshow -i <interface_name>    # Show specific interface\n");
+    out_puts(ob, "  ifshow -i <a>,<b> [-i <c>]    # Show several interfaces, in that order\n");
+    out_puts(ob, "  ifshow -i 'veth*'             # Show every interface matching a glob (*, ?, [...])\n");
+    out_puts(ob, "  ifshow -w [-i <name>]         # Show, then follow address changes\n");
+    out_puts(ob, "  ifshow --all-netns[=proc]     # Show all interfaces of every network namespace\n");
+    out_puts(ob, "  ifshow --owner <ip>|-         # Print the interface owning each address (- reads stdin)\n");
+    out_puts(ob, "  ifshow --rate <ms> [-i <name>] # Print rx/tx bytes and packets per second over <ms>\n");
+    out_puts(ob, "  ifshow --count [-a|-i <name>]  # Print '<name> <ipv4 count> <ipv6 count>' per interface\n");
+    out_puts(ob, "  ifshow --exists -i <name>     # Exit 0 if the interface has an address, 1 otherwise\n");
+    out_puts(ob, "  ifshow --wait -i <name> [--timeout <ms>] # Block until it has a (filtered) address, then show it\n");
+    out_puts(ob, "  ifshow --serve-stdin          # Answer 'show|owner|count|exists ...' lines from one cached snapshot\n");
+    out_puts(ob, "  ifshow --daemon <socket>      # Serve '-a' from an event-updated snapshot on a unix socket\n");
+    out_puts(ob, "  ifshow -a --via <socket>      # Fetch '-a' from that daemon instead of dumping\n");
+    out_puts(ob, "  ifshow --save <file>          # Write the current addresses to a state file\n");
+    out_puts(ob, "  ifshow --diff <file> [--save <file>] # Print +/-/~ changes since that state\n");
+    out_puts(ob, "  ifshow --read <file>          # Print a '--format=bin' document in the selected format\n");
+    out_puts(ob, "\nOptions:\n");
+    out_printf(ob, "  --backend=netlink|sysctl|getifaddrs # Enumeration backend (default: %s)\n", backend_name());
+    out_puts(ob, "  --json                        # One JSON document\n");
+    out_puts(ob, "  --ndjson                      # One JSON record per address, streamed\n");
+    out_puts(ob, "  --format=text|json|ndjson|openmetrics|bin # Output format (--json / --ndjson are shorthands)\n");
+    out_puts(ob, "  --output <file>               # Write to <file>.tmp, then rename it over <file>\n");
+    out_puts(ob, "  --stats                       # Also print rx/tx link counters per interface\n");
+    out_puts(ob, "  -l                            # Also print link flags, MTU and hardware address per interface\n");
+    out_puts(ob, "  --summarize                   # Merge each interface's host addresses into prefixes\n");
+    out_puts(ob, "  --timings                     # Report phase durations and counts on stderr\n");
+    out_puts(ob, "  -j <n>                        # Format large snapshots on <n> threads (-a / -i)\n");
+    out_puts(ob, "  --sort=index|name|addr        # Deterministic order: by ifindex, name or address\n");
+    out_puts(ob, "  -4 / -6                       # Only IPv4 / only IPv6 addresses\n");
+    out_puts(ob, "  --scope=host|link|site|global # Only addresses of these scopes (comma-separated)\n");
+    out_puts(ob, "  --in <cidr>                   # Only addresses inside this network (repeatable)\n");
+    out_puts(ob, "\nExamples:\n");
+    out_puts(ob, "  ifshow -a\n");
+    out_puts(ob, "  ifshow -i eth0\n");
+    out_puts(ob, "  ifshow -w -i eth0\n");
+    out_puts(ob, "  ifshow --exists -i eth0 -4 --scope=global && echo up\n");
+    out_puts(ob, "  ifshow -a -4 --in 10.0.0.0/8\n");
+    out_puts(ob, "  ifshow --owner 192.0.2.10\n");
+    out_puts(ob, "  ifshow -a --stats --format=openmetrics --output /var/lib/node_exporter/ifshow.prom\n");
+    out_puts(ob, "\nNotes:\n");
+    out_puts(ob, "  Addresses include netmask as address/prefix.\n");
+    out_puts(ob, "  IPv4 also shows dotted mask in parentheses.\n");
+    out_puts(ob, "  Watch mode prints '+ <if> <addr>' / '- <if> <addr>' per change.\n\n");
+}
+
+static struct addr_filter addr_filter; // set once by main()
+
+static int show_stats; // --stats: print link counters with the addresses
+static int show_link;  // -l: print link flags, MTU and hardware address with the addresses
+static int summarize;  // --summarize: merge each interface's host addresses into prefixes
+
+/**
+ * @brief Visit every IPv4/IPv6 address through the selected backend.
+ *
+ * Safe to call from worker threads: it only reports failure. Addresses
+ * rejected by the command-line filter never reach `visit`. The call counts
+ * as enumeration time for --timings.
+ *
+ * @param ifname Only visit addresses of this interface, or NULL for all.
+ * @param visit  Visitor called per address.
+ * @param ctx    Opaque pointer handed to the visitor.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+static int enumerate_backend(const char *ifname, addr_visit_fn visit, void *ctx) {
+    double start = timing_begin();
+    int rc = enumerate_with(backend, NULL, &addr_filter, ifname, visit, ctx, timings_enabled ? &timings.entries : NULL);
+    timing_end(&timings.enumerate_ms, start);
+    return rc;
+}
+
+/**
+ * @brief Visit every IPv4/IPv6 address through the selected backend.
+ *
+ * Exits the process (after `perror`) if the backend fails.
+ *
+ * @param ifname Only visit addresses of this interface, or NULL for all.
+ * @param visit  Visitor called per address.
+ * @param ctx    Opaque pointer handed to the visitor.
+ */
+static void enumerate_addresses(const char *ifname, addr_visit_fn visit, void *ctx) {
+    if (enumerate_backend(ifname, visit, ctx) != 0) {
+        perror(backend_name());
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Read every link, with what --stats and -l print of them.
+ *
+ * One RTM_GETLINK dump gives counters and link-layer state together; without
+ * netlink (-l alone), the link-layer state comes from getifaddrs.
+ *
+ * @param t  Link table to fill (zeroed).
+ * @return 0 on success; -1 on failure (errno set, ENOTSUP for counters off Linux).
+ */
+static int link_table_load(struct link_table *t) {
+    t->fields = (show_stats ? LINK_COUNTERS : 0) | (show_link ? LINK_LAYER : 0);
+    double start = timing_begin();
+    int rc = backend != BACKEND_NETLINK && !show_stats ? link_table_ifaddrs(t) : link_table_load_on(NULL, t);
+    timing_end(&timings.enumerate_ms, start);
+    return rc;
+}
+
+static enum output_format output_format = FORMAT_TEXT;
+
+/**
+ * @brief Create a printer for the selected output format.
+ *
+ * @param ob      Output buffer to write to.
+ * @param single  Non-zero when printing the result of `-i`.
+ * @return Printer with fresh state.
+ */
+static struct printer printer_open(struct outbuf *ob, int single) {
+    struct printer p = { .ops = printer_ops_for(output_format), .ob = ob, .single = single };
+    return p;
+}
+
+static enum sort_order sort_order = SORT_NONE;
+
+/**
+ * @brief Sort a snapshot by --sort, then group and --summarize it when asked.
+ *
+ * The call counts as grouping time for --timings.
+ *
+ * @param s      Filled snapshot.
+ * @param group  Non-zero to group it by interface (--summarize groups anyway).
+ */
+static void snapshot_arrange(struct snapshot *s, int group) {
+    double start = timing_begin();
+    snapshot_sort(s, sort_order);
+    if (group) snapshot_group(s);
+    if (summarize) snapshot_summarize(s);
+    timing_end(&timings.group_ms, start);
+}
+
+/**
+ * @brief Release a snapshot, counting its interfaces and addresses for --timings.
+ *
+ * @param s  Snapshot (left zeroed and reusable).
+ */
+static void snapshot_release(struct snapshot *s) {
+    timings.interfaces += s->name_count;
+    timings.addresses += s->addr_count;
+    snapshot_free(s);
+}
+
+#define FORMAT_MAX_JOBS 64
+#define FORMAT_PARALLEL_MIN 16384 // addresses below which threads cost more than they save
+
+static long format_jobs = 1; // -j: threads formatting one snapshot
+
+/**
+ * @brief A range of snapshot units formatted by one worker into its own buffer.
+ */
+struct format_chunk {
+    size_t lo, hi;      // units [lo, hi), see print_snapshot_range()
+    struct outbuf out;  // memory-only
+};
+
+/**
+ * @brief Chunks of one snapshot and the work queue shared by the workers.
+ */
+struct format_pool {
+    const struct printer *p;    // template; each chunk prints through a copy
+    const struct snapshot *s;
+    int seeded;
+    struct format_chunk *chunks;
+    size_t count;
+    atomic_size_t next;         // next chunk index to hand out
+};
+
+/**
+ * @brief Worker thread (and the calling thread): format chunks from the queue.
+ *
+ * @param arg  `struct format_pool`.
+ * @return NULL.
+ */
+static void *format_worker(void *arg) {
+    struct format_pool *pool = arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&pool->next, 1);
+        if (i >= pool->count) return NULL;
+        struct format_chunk *c = &pool->chunks[i];
+        struct printer p = *pool->p;
+        p.ob = &c->out;
+        p.ifaces += c->lo; // JSON comma placement: every earlier interface is printed by an earlier chunk
+        print_snapshot_range(&p, pool->s, pool->seeded, c->lo, c->hi);
+    }
+}
+
+/**
+ * @brief Print a whole snapshot like print_snapshot(), formatting on -j threads.
+ *
+ * The units (interfaces, or records for streaming formats) are cut into a
+ * few chunks per thread, balanced on their address count. Workers format
+ * chunks into private buffers, which are then appended in order, so the
+ * output is byte-identical to the serial path. Small snapshots stay serial,
+ * and no more threads than online CPUs are used.
+ *
+ * @param p       Printer.
+ * @param s       Filled snapshot.
+ * @param seeded  Non-zero when the names were interned before enumerating.
+ */
+static void print_snapshot_jobs(struct printer *p, struct snapshot *s, int seeded) {
+    int by_name = p->ops->grouped || seeded;
+    size_t units = by_name ? s->name_count : s->addr_count;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t jobs = (size_t)format_jobs;
+    if (cpus > 0 && jobs > (size_t)cpus) jobs = (size_t)cpus; // more threads than CPUs only add switches
+    if (jobs <= 1 || s->addr_count < FORMAT_PARALLEL_MIN || units < 2 || output_format == FORMAT_BIN) { // bin: sections assembled in `end`
+        print_snapshot(p, s, seeded);
+        return;
+    }
+    if (by_name && !s->order) snapshot_group(s);
+
+    size_t want = jobs * 4; // a few chunks per thread absorb uneven interfaces
+    if (want > units) want = units;
+    size_t total = by_name ? s->addr_count + s->name_count : s->addr_count, acc = 0;
+    struct format_pool pool = { .p = p, .s = s, .seeded = seeded };
+    pool.chunks = xrealloc(NULL, want * sizeof(*pool.chunks));
+    for (size_t i = 0, lo = 0; i < units; ++i) {
+        acc += by_name ? s->names[i].count + 1u : 1u; // +1: the header / missing line of each interface
+        if (acc * want >= (pool.count + 1) * total || i + 1 == units) {
+            struct format_chunk *c = &pool.chunks[pool.count++];
+            memset(c, 0, sizeof(*c));
+            c->lo = lo;
+            c->hi = lo = i + 1;
+            c->out.fd = -1;
+        }
+    }
+    atomic_init(&pool.next, 0);
+
+    pthread_t threads[FORMAT_MAX_JOBS];
+    size_t started = 0;
+    while (started + 1 < jobs && started + 1 < pool.count) {
+        if (pthread_create(&threads[started], NULL, format_worker, &pool) != 0) break; // fewer helpers, same output
+        started++;
+    }
+    format_worker(&pool);
+    for (size_t i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+
+    p->ops->begin(p);
+    for (size_t i = 0; i < pool.count; ++i) {
+        out_write(p->ob, pool.chunks[i].out.data, pool.chunks[i].out.len);
+        free(pool.chunks[i].out.data);
+    }
+    p->ifaces += units;
+    print_snapshot_links(p, s, seeded);
+    p->ops->end(p);
+    free(pool.chunks);
+}
+
+/**
+ * @brief Render all interfaces with their IP addresses through a printer.
+ *
+ * Collects every address from the selected backend into one snapshot, groups
+ * it by interface name, and prints IPv4/IPv6 addresses with prefixes.
+ * Interfaces appear in first-seen order and addresses keep their backend order;
+ * with --stats / -l, links without addresses follow (see snapshot_add_links()).
+ * Streaming formats (NDJSON) skip the grouping and keep backend order.
+ *
+ * @param p  Printer (and output buffer) to render into.
+ * @return 0 on success; -1 on enumeration failure (errno set, output incomplete).
+ */
+static int render_all_interfaces(struct printer *p) {
+    struct link_table links = {0};
+    if (show_stats || show_link) {
+        if (link_table_load(&links) != 0) return -1;
+        p->links = &links;
+    }
+    struct snapshot snap = {0};
+    int rc = enumerate_backend(NULL, snapshot_add, &snap);
+    if (rc == 0 && p->links) snapshot_add_links(&snap, p->links); // links without addresses, as streaming formats list them
+    if (rc == 0) snapshot_arrange(&snap, p->ops->grouped);
+    double start = timing_begin();
+    if (rc == 0 && p->netns) print_snapshot(p, &snap, 0); // --all-netns already spreads namespaces over threads
+    if (rc == 0 && !p->netns) print_snapshot_jobs(p, &snap, 0);
+    timing_end(&timings.format_ms, start);
+    snapshot_release(&snap);
+    p->links = NULL;
+    free(links.links);
+    return rc;
+}
+
+/**
+ * @brief Load the --stats / -l links for a printer, exiting on failure.
+ *
+ * @param p      Printer whose `links` is set when --stats or -l is on.
+ * @param links  Storage for the links (zeroed).
+ */
+static void printer_load_links(struct printer *p, struct link_table *links) {
+    if (!show_stats && !show_link) return;
+    if (link_table_load(links) != 0) {
+        perror(backend == BACKEND_NETLINK || show_stats ? "netlink" : "getifaddrs");
+        exit(EXIT_FAILURE);
+    }
+    p->links = links;
+}
+
+/**
+ * @brief Enumerate and display all interfaces with their IP addresses.
+ *
+ * Exits the process on enumeration failure.
+ */
+static void show_all_interfaces(void) {
+    struct printer p = printer_open(&stdout_buf, 0);
+    size_t mark = stdout_buf.len;
+    if (render_all_interfaces(&p) != 0) {
+        int saved = errno;
+        stdout_buf.len = mark; // drop the partial document
+        errno = saved;
+        perror(backend_name());
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Print what was found for one requested interface.
+ *
+ * @param p       Printer.
+ * @param ifname  Requested interface name.
+ * @param s       Snapshot restricted to that interface by the backend.
+ */
+static void print_single_group(struct printer *p, const char *ifname, struct snapshot *s) {
+    if (!s->order) snapshot_group(s);
+    print_snapshot_group(p, ifname, s, snapshot_find(s, ifname));
+}
+
+/**
+ * @brief Display IP addresses for a specific interface.
+ *
+ * Prints IPv4/IPv6 addresses (with prefixes) for the given interface name.
+ * If the interface is not found or has no IP addresses, prints a message, not stderr
+ * (with -l or --stats, a link without addresses shows its link lines instead).
+ * Exits the process on enumeration failure.
+ *
+ * Looks relly the same as "show_all_interfaces() function detailed above
+ *
+ * @param target_ifname  Name of the interface to display.
+ */
+static void show_single_interface(const char *target_ifname) {
+    struct printer p = printer_open(&stdout_buf, 1);
+    struct snapshot snap = {0};
+    struct link_table links = {0};
+    printer_load_links(&p, &links);
+    snapshot_intern(&snap, target_ifname); // reported even without addresses, like show_interfaces() does
+    enumerate_addresses(target_ifname, snapshot_add, &snap);
+    snapshot_arrange(&snap, 1);
+    double start = timing_begin();
+    print_snapshot(&p, &snap, 1);
+    timing_end(&timings.format_ms, start);
+    snapshot_release(&snap);
+    free(links.links);
+}
+
+/**
+ * @brief What snapshot_add_matching() selects with: interned names plus patterns.
+ */
+struct glob_select {
+    struct snapshot *snap;      // seeded with the literal names
+    struct name_glob *globs;
+    size_t count;
+};
+
+/**
+ * @brief Visitor appending an address if its name is interned or matches a pattern.
+ *
+ * A name matching a pattern is interned on its first address, so the
+ * patterns run once per address of the names they do not select, and
+ * never again for those they do.
+ *
+ * @param ai   Visited address.
+ * @param ctx  `struct glob_select`.
+ * @return Always 0 (keep enumerating).
+ */
+static int snapshot_add_matching(const struct addr_info *ai, void *ctx) {
+    struct glob_select *sel = ctx;
+    uint32_t name = snapshot_find(sel->snap, ai->ifname);
+    for (size_t i = 0; name == SNAP_NONE && i < sel->count; ++i) {
+        if (!name_glob_match(&sel->globs[i], ai->ifname)) continue;
+        sel->globs[i].matched = 1;
+        name = snapshot_intern(sel->snap, ai->ifname);
+    }
+    if (name != SNAP_NONE) snapshot_append(sel->snap, name, ai);
+    return 0;
+}
+
+/**
+ * @brief Display IP addresses for several interfaces from one enumeration.
+ *
+ * A single name keeps the filtered lookup of show_single_interface(). With
+ * more, the snapshot is seeded with the requested names (duplicates collapse
+ * onto the first), so one full dump fills it through a hash lookup per
+ * address and output follows the requested order. Patterns are compiled
+ * once and select the other names during that same dump; their interfaces
+ * follow the literal names, in first-seen order. Names without any address,
+ * and patterns matching no interface, are reported like
+ * show_single_interface() does.
+ * Exits the process on enumeration failure.
+ *
+ * @param names  Requested interface names or patterns.
+ * @param count  Number of names (>= 1).
+ */
+static void show_interfaces(const char *const *names, size_t count) {
+    size_t patterns = 0;
+    for (size_t i = 0; i < count; ++i) patterns += name_is_glob(names[i]);
+    if (count == 1 && !patterns) {
+        show_single_interface(names[0]);
+        return;
+    }
+    struct printer p = printer_open(&stdout_buf, 0);
+    struct snapshot snap = {0};
+    struct link_table links = {0};
+    printer_load_links(&p, &links);
+    struct glob_select sel = { .snap = &snap, .globs = xrealloc(NULL, (patterns ? patterns : 1) * sizeof(*sel.globs)) };
+    for (size_t i = 0; i < count; ++i) {
+        if (name_is_glob(names[i])) {
+            name_glob_compile(&sel.globs[sel.count++], names[i]);
+        } else {
+            snapshot_intern(&snap, names[i]);
+        }
+    }
+    if (patterns) {
+        enumerate_addresses(NULL, snapshot_add_matching, &sel);
+    } else {
+        enumerate_addresses(NULL, snapshot_add_known, &snap);
+    }
+    uint32_t selected = snap.name_count;
+    for (size_t i = 0; i < sel.count; ++i) {
+        struct name_glob *g = &sel.globs[i];
+        for (uint32_t n = 0; !g->matched && n < selected; ++n) g->matched = name_glob_match(g, snap.names[n].name); // e.g. a literal name
+        if (!g->matched) snapshot_intern(&snap, g->text);
+        name_glob_free(g);
+    }
+    free(sel.globs);
+    snapshot_arrange(&snap, 1);
+    double start = timing_begin();
+    print_snapshot_jobs(&p, &snap, 1);
+    timing_end(&timings.format_ms, start);
+    snapshot_release(&snap);
+    free(links.links);
+}
+
+/**
+ * @brief Signature of --save state files; bump it whenever `struct state_record` changes.
+ */
+#define STATE_MAGIC "IFSHOWS1"
+
+/**
+ * @brief One address in a --save state file.
+ *
+ * Fixed size and in host byte order: state files are meant to be read back
+ * by the same machine. Records are sorted by (ifname, family, address, prefix).
+ */
+struct state_record {
+    char ifname[IF_NAMESIZE];
+    uint32_t ifindex;
+    unsigned char addr[16];
+    int16_t prefix;
+    uint8_t family;
+    uint8_t scope;
+};
+
+/**
+ * @brief State file header, followed by `count` records.
+ */
+struct state_header {
+    char magic[8];          // STATE_MAGIC, not NUL-terminated
+    uint32_t record_size;   // sizeof(struct state_record), catches layout mismatches
+    uint32_t count;
+};
+
+/**
+ * @brief Order two state records on their identity (name, family, address).
+ *
+ * The prefix is left out on purpose: an address whose prefix changed is
+ * reported as changed, not as removed and added.
+ *
+ * @return <0, 0 or >0 like strcmp().
+ */
+static int state_cmp(const struct state_record *a, const struct state_record *b) {
+    int c = strncmp(a->ifname, b->ifname, IF_NAMESIZE);
+    if (c) return c;
+    if (a->family != b->family) return a->family < b->family ? -1 : 1;
+    return memcmp(a->addr, b->addr, sizeof(a->addr));
+}
+
+/**
+ * @brief Expand a state record into the `addr_info` printers take.
+ *
+ * @param r   Record.
+ * @param ai  Receives the address; `ifname` points into the record.
+ */
+static void state_record_info(const struct state_record *r, struct addr_info *ai) {
+    ai->ifname = r->ifname;
+    ai->ifindex = r->ifindex;
+    ai->family = r->family;
+    ai->prefix = r->prefix;
+    ai->scope = r->scope;
+    memcpy(ai->addr, r->addr, sizeof(ai->addr));
+}
+
+/**
+ * @brief Enumerate the current addresses as sorted state records.
+ *
+ * @param snap   Empty snapshot; holds the records until snapshot_free().
+ * @param names  -i names to restrict to, or NULL for every interface.
+ * @param count  Number of names.
+ * @param out    Receives the record count.
+ * @return Records in state file order (allocated in the snapshot arena).
+ */
+static struct state_record *state_capture(struct snapshot *snap, const char *const *names, size_t count, size_t *out) {
+    for (size_t i = 0; i < count; ++i) snapshot_intern(snap, names[i]);
+    enumerate_addresses(NULL, count ? snapshot_add_known : snapshot_add, snap);
+    double start = timing_begin();
+    snapshot_sort(snap, SORT_NAME); // strcmp name order, then family / address / prefix: what state_cmp() expects
+    struct state_record *records = arena_alloc(&snap->arena, (snap->addr_count ? snap->addr_count : 1) * sizeof(*records));
+    memset(records, 0, snap->addr_count * sizeof(*records)); // names are padded with NULs
+    for (uint32_t i = 0; i < snap->addr_count; ++i) {
+        const struct snap_addr *a = &snap->addrs[i];
+        struct state_record *r = &records[i];
+        strncpy(r->ifname, snap->names[a->name].name, IF_NAMESIZE - 1);
+        r->ifindex = a->ifindex;
+        memcpy(r->addr, a->addr, sizeof(r->addr));
+        r->prefix = a->prefix;
+        r->family = a->family;
+        r->scope = a->scope;
+    }
+    timing_end(&timings.group_ms, start);
+    *out = snap->addr_count;
+    return records;
+}
+
+/**
+ * @brief Write a state file atomically: a temporary file next to it, then rename(2).
+ *
+ * Readers (including a concurrent `--diff`) see either the old or the new
+ * file, never a partial one. Exits the process on failure.
+ *
+ * @param path     State file path.
+ * @param records  Sorted records.
+ * @param count    Number of records.
+ */
+static void state_save(const char *path, const struct state_record *records, size_t count) {
+    struct state_header h = { .record_size = sizeof(struct state_record), .count = (uint32_t)count };
+    memcpy(h.magic, STATE_MAGIC, sizeof(h.magic));
+    struct atomic_file f;
+    atomic_file_open(&f, path);
+    struct outbuf ob = { .fd = f.fd };
+    out_write(&ob, &h, sizeof(h));
+    if (count) out_write(&ob, records, count * sizeof(*records));
+    if (out_flush(&ob) != 0) {
+        perror(f.tmp);
+        atomic_file_abort(&f);
+        exit(EXIT_FAILURE);
+    }
+    free(ob.data);
+    if (atomic_file_commit(&f) != 0) exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Read a state file written by state_save().
+ *
+ * A missing file is an empty state, so `--diff f --save f` works from the
+ * first run. Anything else that is not a well-formed, sorted state file
+ * exits the process with an error.
+ *
+ * @param path   State file path.
+ * @param count  Receives the number of records.
+ * @return Records (free() them), or NULL when there are none.
+ */
+static struct state_record *state_load(const char *path, size_t *count) {
+    *count = 0;
+    double start = timing_begin();
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        if (errno == ENOENT) return NULL;
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    struct state_header h;
+    struct state_record *records = NULL;
+    int bad = fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, STATE_MAGIC, sizeof(h.magic)) != 0 ||
+              h.record_size != sizeof(struct state_record);
+    if (!bad && h.count) {
+        records = xrealloc(NULL, (size_t)h.count * sizeof(*records));
+        bad = fread(records, sizeof(*records), h.count, f) != h.count;
+    }
+    bad |= fgetc(f) != EOF; // trailing bytes: not written by us
+    for (uint32_t i = 0; !bad && i < h.count; ++i) {
+        const struct state_record *r = &records[i];
+        bad = memchr(r->ifname, '\0', IF_NAMESIZE) == NULL || (r->family != AF_INET && r->family != AF_INET6) ||
+              (i && state_cmp(&records[i - 1], r) > 0); // the merge in show_state() relies on the order
+    }
+    fclose(f);
+    if (bad) {
+        fprintf(stderr, "ifshow: %s: not an ifshow state file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    timing_end(&timings.enumerate_ms, start);
+    *count = h.count;
+    return records;
+}
+
+/**
+ * @brief Save and/or diff the current addresses against a state file.
+ *
+ * With `diff_path`, the saved records and the current ones (both sorted the
+ * same way) are compared in one linear merge: addresses only in the current
+ * set are reported as '+', only in the saved one as '-', and addresses
+ * present in both with another prefix as '~' (with their current value).
+ * The state is read before it is saved, so both may name the same file.
+ *
+ * @param save_path  --save file, or NULL.
+ * @param diff_path  --diff file, or NULL.
+ * @param names      -i names to restrict to, or NULL for every interface.
+ * @param count      Number of names.
+ * @return `EXIT_SUCCESS`; exits the process on failure.
+ */
+static int show_state(const char *save_path, const char *diff_path, const char *const *names, size_t count) {
+    struct snapshot snap = {0};
+    size_t now_count;
+    struct state_record *now = state_capture(&snap, names, count, &now_count);
+    if (diff_path) {
+        size_t old_count, i = 0, j = 0;
+        struct state_record *old = state_load(diff_path, &old_count);
+        struct printer p = printer_open(&stdout_buf, 0);
+        struct addr_info ai;
+        double start = timing_begin();
+        p.ops->begin(&p);
+        while (i < old_count || j < now_count) {
+            int c = i == old_count ? 1 : j == now_count ? -1 : state_cmp(&old[i], &now[j]);
+            if (c < 0) {
+                state_record_info(&old[i++], &ai);
+                p.ops->event(&p, '-', &ai);
+            } else if (c > 0) {
+                state_record_info(&now[j++], &ai);
+                p.ops->event(&p, '+', &ai);
+            } else {
+                if (old[i].prefix != now[j].prefix) {
+                    state_record_info(&now[j], &ai);
+                    p.ops->event(&p, '~', &ai);
+                }
+                i++;
+                j++;
+            }
+        }
+        p.ops->end(&p);
+        timing_end(&timings.format_ms, start);
+        free(old);
+    }
+    if (save_path) state_save(save_path, now, now_count);
+    snapshot_release(&snap);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Read a stream to its end into memory (pipes, /dev/stdin, other non-regular files).
+ *
+ * @param fd    Open descriptor.
+ * @param data  Receives the bytes (free() them), NULL when nothing was read.
+ * @param len   Receives the number of bytes.
+ * @return 0 on success; -1 on a read error (errno set, nothing to free).
+ */
+static int read_all(int fd, unsigned char **data, size_t *len) {
+    unsigned char *buf = NULL;
+    size_t n = 0, cap = 0;
+    for (;;) {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 65536;
+            buf = xrealloc(buf, cap);
+        }
+        ssize_t got = read(fd, buf + n, cap - n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            int saved = errno;
+            free(buf);
+            errno = saved;
+            return -1;
+        }
+        if (got == 0) break;
+        n += (size_t)got;
+    }
+    *data = buf;
+    *len = n;
+    return 0;
+}
+
+/**
+ * @brief Print a --format=bin document through the selected printer (--read).
+ *
+ * A regular file is mapped and decoded in place; anything else (a pipe,
+ * /dev/stdin) is read to its end first. The snapshot is decoded with the
+ * -4 / -6 / --scope / --in filter applied, then sorted, summarized and
+ * printed like `-a` would. Interfaces keep the document's order unless
+ * --sort is given. Exits the process if the file cannot be opened or read
+ * (reported with its errno, e.g. for a directory) or is not a bin document.
+ *
+ * @param path  Document to read.
+ * @return `EXIT_SUCCESS`.
+ */
+static int show_read(const char *path) {
+    double start = timing_begin();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    if (S_ISDIR(st.st_mode)) {
+        errno = EISDIR;
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    int mapped = S_ISREG(st.st_mode) && st.st_size > 0;
+    unsigned char *data = NULL;
+    size_t len = 0;
+    if (mapped) {
+        len = (size_t)st.st_size;
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            perror(path);
+            exit(EXIT_FAILURE);
+        }
+        data = map;
+    } else if (read_all(fd, &data, &len) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    struct snapshot snap = {0};
+    int rc = bin_decode(&snap, data, len, &addr_filter);
+    if (mapped) {
+        munmap(data, len);
+    } else {
+        free(data);
+    }
+    if (rc != 0) {
+        fprintf(stderr, "ifshow: %s: not an ifshow bin document\n", path);
+        exit(EXIT_FAILURE);
+    }
+    timing_end(&timings.enumerate_ms, start);
+    struct printer p = printer_open(&stdout_buf, 0);
+    snapshot_arrange(&snap, 1);
+    start = timing_begin();
+    print_snapshot(&p, &snap, 1);
+    timing_end(&timings.format_ms, start);
+    snapshot_release(&snap);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Fill a count table from one enumeration.
+ *
+ * A single name goes through the backend's own interface filter. Exits the
+ * process on enumeration failure.
+ *
+ * @param t                Zeroed table to fill.
+ * @param names            -i names, or NULL for every interface.
+ * @param count            Number of names.
+ * @param stop_when_found  --exists: stop at the first address of the last name found.
+ */
+static void count_table_fill(struct count_table *t, const char *const *names, size_t count, int stop_when_found) {
+    count_table_seed(t, names, count, stop_when_found);
+    enumerate_addresses(t->names.name_count == 1 ? names[0] : NULL, count_visit, t);
+}
+
+/**
+ * @brief Release a count table.
+ */
+static void count_table_free(struct count_table *t) {
+    for (uint32_t i = 0; i < t->names.name_count; ++i) timings.addresses += t->entries[i].inet + t->entries[i].inet6;
+    snapshot_release(&t->names);
+    free(t->entries);
+}
+
+static const struct count_table *count_sort_table; // qsort has no context argument
+
+/**
+ * @brief qsort order for --count: interfaces with addresses first, by (ifindex,) name.
+ */
+static int count_cmp(const void *a, const void *b) {
+    const struct count_entry *x = a, *y = b;
+    int ex = !x->inet && !x->inet6, ey = !y->inet && !y->inet6;
+    if (ex != ey) return ex - ey;
+    if (ex) return (x->name > y->name) - (x->name < y->name); // like snapshot_sort(): name-less ones keep their order
+    if (sort_order == SORT_INDEX && x->ifindex != y->ifindex) return x->ifindex < y->ifindex ? -1 : 1;
+    return strcmp(count_sort_table->names.names[x->name].name, count_sort_table->names.names[y->name].name);
+}
+
+/**
+ * @brief Print a filled count table in the selected format (and --sort order).
+ *
+ * @param ob  Output buffer.
+ * @param t   Count table; its entries are reordered.
+ */
+static void print_counts(struct outbuf *ob, struct count_table *t) {
+    size_t n = t->names.name_count;
+    if (sort_order != SORT_NONE) {
+        for (size_t i = 0; i < n; ++i) {
+            if (!t->entries[i].ifindex) t->entries[i].ifindex = if_nametoindex(t->names.names[i].name); // getifaddrs
+        }
+        count_sort_table = t;
+        qsort(t->entries, n, sizeof(*t->entries), count_cmp);
+    }
+
+    double start = timing_begin();
+    if (output_format == FORMAT_JSON) out_puts(ob, "{\"interfaces\":[");
+    if (output_format == FORMAT_OPENMETRICS) {
+        out_puts(ob, "# HELP ifshow_addresses Addresses configured on an interface.\n# TYPE ifshow_addresses gauge\n");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const struct count_entry *e = &t->entries[i];
+        const char *name = t->names.names[e->name].name;
+        if (output_format == FORMAT_TEXT) {
+            out_printf(ob, "%s %zu %zu\n", name, e->inet, e->inet6);
+        } else if (output_format == FORMAT_OPENMETRICS) {
+            out_puts(ob, "ifshow_addresses{ifname=");
+            openmetrics_label(ob, name);
+            out_printf(ob, ",family=\"inet\"} %zu\nifshow_addresses{ifname=", e->inet);
+            openmetrics_label(ob, name);
+            out_printf(ob, ",family=\"inet6\"} %zu\n", e->inet6);
+        } else {
+            if (output_format == FORMAT_JSON && i) out_puts(ob, ",");
+            out_puts(ob, "{\"ifname\":");
+            json_string(ob, name);
+            out_printf(ob, ",\"inet\":%zu,\"inet6\":%zu}", e->inet, e->inet6);
+            if (output_format == FORMAT_NDJSON) out_puts(ob, "\n");
+        }
+    }
+    if (output_format == FORMAT_JSON) out_puts(ob, "]}\n");
+    if (output_format == FORMAT_OPENMETRICS) out_puts(ob, "# EOF\n");
+    timing_end(&timings.format_ms, start);
+}
+
+/**
+ * @brief Print how many IPv4/IPv6 addresses each interface has (--count).
+ *
+ * Addresses are counted straight from the enumeration: nothing is copied
+ * into a snapshot or converted to text. Requested names without any
+ * address are listed with zero counts.
+ *
+ * @param names  -i names, or NULL for every interface.
+ * @param count  Number of names.
+ * @return `EXIT_SUCCESS`; exits the process on failure.
+ */
+static int show_counts(const char *const *names, size_t count) {
+    struct count_table t = {0};
+    count_table_fill(&t, names, count, 0);
+    print_counts(&stdout_buf, &t);
+    count_table_free(&t);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Tell through the exit status whether every interface has an address (--exists).
+ *
+ * Prints nothing. The enumeration stops at the first address that completes
+ * the answer; with a single name the backend only dumps that interface.
+ *
+ * @param names  -i names.
+ * @param count  Number of names (>= 1).
+ * @return `EXIT_SUCCESS` if each has at least one (filtered) address, else `EXIT_FAILURE`.
+ */
+static int show_exists(const char *const *names, size_t count) {
+    struct count_table t = {0};
+    count_table_fill(&t, names, count, 1);
+    int status = t.missing == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    count_table_free(&t);
+    return status;
+}
+
+/**
+ * @brief Print one link's rates for --rate.
+ *
+ * @param ob       Output buffer.
+ * @param before   First sample (same name and ifindex), or NULL if the link is new.
+ * @param after    Second sample.
+ * @param elapsed  Seconds between the samples.
+ * @param first    Non-zero for the first JSON array element.
+ * @param interval_ms  Requested interval, echoed in NDJSON records.
+ */
+static void print_link_rate(struct outbuf *ob, const struct link_stats *before, const struct link_stats *after,
+                            double elapsed, int first, long interval_ms) {
+    struct link_stats zero = {0};
+    if (!before || before->ifindex != after->ifindex) before = &zero; // recreated device: counters restarted
+    // Counters only grow; a smaller value means a reset, counted from zero.
+#define RATE(field) ((after->field >= before->field ? after->field - before->field : after->field) / elapsed)
+    double rxb = RATE(rx_bytes), rxp = RATE(rx_packets), txb = RATE(tx_bytes), txp = RATE(tx_packets);
+#undef RATE
+    if (output_format == FORMAT_TEXT) {
+        out_printf(ob, "%s: rx %.0f B/s %.0f pkt/s, tx %.0f B/s %.0f pkt/s\n", after->name, rxb, rxp, txb, txp);
+        return;
+    }
+    if (output_format == FORMAT_JSON) {
+        out_puts(ob, first ? "{\"ifname\":" : ",{\"ifname\":");
+    } else {
+        out_printf(ob, "{\"interval_ms\":%ld,\"ifname\":", interval_ms);
+    }
+    json_string(ob, after->name);
+    out_printf(ob, ",\"rx_bytes_per_s\":%.1f,\"rx_packets_per_s\":%.1f,\"tx_bytes_per_s\":%.1f,\"tx_packets_per_s\":%.1f}",
+               rxb, rxp, txb, txp);
+    if (output_format == FORMAT_NDJSON) out_puts(ob, "\n");
+}
+
+/**
+ * @brief Sample link counters twice and print per-second rates (--rate).
+ *
+ * Each sample is a single RTM_GETLINK dump; the actual time between the two
+ * dumps (not the requested interval) is used for the division.
+ *
+ * @param names        Interfaces to report, in that order, or NULL for every link (sorted by name).
+ * @param count        Number of names.
+ * @param interval_ms  Time to wait between the samples.
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if a requested interface does not exist.
+ */
+static int show_rates(const char *const *names, size_t count, long interval_ms) {
+    struct link_table before = {0}, after = {0};
+    if (link_table_load(&before) != 0) {
+        perror("netlink");
+        exit(EXIT_FAILURE);
+    }
+    double t0 = monotonic_ms();
+    struct timespec wait = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+    while (nanosleep(&wait, &wait) != 0 && errno == EINTR) {}
+    if (link_table_load(&after) != 0) {
+        perror("netlink");
+        exit(EXIT_FAILURE);
+    }
+    double elapsed = (monotonic_ms() - t0) / 1e3;
+
+    struct outbuf *ob = &stdout_buf;
+    int status = EXIT_SUCCESS;
+    size_t shown = 0;
+    if (output_format == FORMAT_JSON) out_printf(ob, "{\"interval_ms\":%ld,\"interfaces\":[", interval_ms);
+    size_t n = names ? count : after.count;
+    for (size_t i = 0; i < n; ++i) {
+        const struct link_stats *ls = names ? link_table_find(&after, names[i]) : &after.links[i];
+        if (!ls) {
+            fprintf(stderr, "ifshow: no such interface: '%s'\n", names[i]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        if (!ls->counters) continue; // a link without IFLA_STATS64 has no rate
+        print_link_rate(ob, link_table_find(&before, ls->name), ls, elapsed, shown++ == 0, interval_ms);
+    }
+    if (output_format == FORMAT_JSON) out_puts(ob, "]}\n");
+    free(before.links);
+    free(after.links);
+    return status;
+}
+
+/**
+ * @brief Answer one --owner query.
+ *
+ * Text: "<ip> <ifname> <addr>/<prefix>", or "<ip> -" without an owner;
+ * NDJSON: {"query":..,"ifname":..,<address members>} with a null ifname
+ * when there is no owner.
+ *
+ * @param ob     Output buffer.
+ * @param t      Index built by prefix_trie_build().
+ * @param snap   Snapshot the index points into.
+ * @param query  Address text, NUL-terminated.
+ * @return 0 if an owner was found; 1 if none; -1 if `query` is not an address (nothing written).
+ */
+static int owner_query(struct outbuf *ob, const struct prefix_trie *t, const struct snapshot *snap, const char *query) {
+    unsigned char key[16];
+    int v6 = strchr(query, ':') != NULL;
+    if (inet_pton(v6 ? AF_INET6 : AF_INET, query, key) != 1) return -1;
+    const struct trie_node *n = prefix_trie_lookup(t, v6, key);
+    struct addr_info ai;
+    if (n) snapshot_addr_info(snap, &snap->addrs[n->entry], &ai);
+    if (output_format == FORMAT_TEXT) {
+        out_puts(ob, query);
+        if (!n) {
+            out_puts(ob, " -\n");
+            return 1;
+        }
+        out_puts(ob, " ");
+        out_puts(ob, ai.ifname);
+        out_puts(ob, " ");
+        format_address(ob, &ai);
+        out_puts(ob, "\n");
+    } else {
+        out_puts(ob, "{\"query\":");
+        json_string(ob, query);
+        if (!n) {
+            out_puts(ob, ",\"ifname\":null}\n");
+            return 1;
+        }
+        out_puts(ob, ",\"ifname\":");
+        json_string(ob, ai.ifname);
+        out_puts(ob, ",");
+        json_address_members(ob, &ai);
+        out_puts(ob, "}\n");
+    }
+    return n ? 0 : 1;
+}
+
+/**
+ * @brief Hand every line read from stdin to a callback.
+ *
+ * Input is read in large chunks and the answers for each chunk are written
+ * before blocking on the next read, so a pipe sees replies promptly without
+ * one write per query. Blank lines are ignored; surrounding whitespace is
+ * trimmed.
+ *
+ * @param answer  Called with each NUL-terminated line; non-zero marks a miss.
+ * @param ctx     Opaque pointer handed to `answer`.
+ * @return 0 if no line missed, 1 otherwise (overlong lines count as misses).
+ */
+static int stdin_lines(int (*answer)(char *line, void *ctx), void *ctx) {
+    char buf[65536];
+    size_t have = 0;
+    int missed = 0, eof = 0;
+    while (!eof) {
+        ssize_t n = read(STDIN_FILENO, buf + have, sizeof(buf) - 1 - have);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+        if (n == 0) {
+            eof = 1;
+            if (have == 0) break;
+            buf[have++] = '\n'; // last line without newline (room was kept for it)
+        } else {
+            have += (size_t)n;
+        }
+        size_t start = 0;
+        for (char *nl; (nl = memchr(buf + start, '\n', have - start)) != NULL; start = (size_t)(nl - buf) + 1) {
+            char *line = buf + start, *end = nl;
+            while (line < end && (*line == ' ' || *line == '\t')) ++line;
+            while (end > line && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) --end;
+            if (line == end) continue;
+            *end = '\0';
+            if (answer(line, ctx) != 0) missed = 1;
+        }
+        if (start == 0 && have == sizeof(buf) - 1) { // one line filling the buffer: not a query anyway
+            fprintf(stderr, "ifshow: input line too long\n");
+            missed = 1;
+            have = 0;
+        } else {
+            memmove(buf, buf + start, have - start);
+            have -= start;
+        }
+        if (out_flush(&stdout_buf) != 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return missed;
+}
+
+/**
+ * @brief An --owner index and the snapshot it points into.
+ */
+struct owner_index {
+    const struct prefix_trie *trie;
+    const struct snapshot *snap;
+};
+
+/**
+ * @brief stdin_lines() callback: answer one --owner query, reporting invalid ones on stderr.
+ *
+ * @param line  Address text.
+ * @param ctx   `struct owner_index`.
+ * @return 0 if the address has an owner, 1 otherwise.
+ */
+static int owner_answer(char *line, void *ctx) {
+    const struct owner_index *ix = ctx;
+    double start = timing_begin();
+    int rc = owner_query(&stdout_buf, ix->trie, ix->snap, line);
+    timing_end(&timings.format_ms, start);
+    if (rc < 0) fprintf(stderr, "ifshow: not an IP address: '%s'\n", line);
+    return rc != 0;
+}
+
+/**
+ * @brief Map addresses to the interface owning them (--owner).
+ *
+ * Takes one snapshot, builds the longest-prefix index once, then answers
+ * every query in O(address bits). A query of "-" reads addresses from
+ * stdin, one per line.
+ *
+ * @param queries  Addresses (or "-") in command-line order.
+ * @param count    Number of queries.
+ * @return EXIT_SUCCESS if every query had an owner, EXIT_FAILURE otherwise.
+ */
+static int show_owners(const char *const *queries, size_t count) {
+    struct snapshot snap = {0};
+    struct prefix_trie trie = {0};
+    enumerate_addresses(NULL, snapshot_add, &snap);
+    double start = timing_begin();
+    prefix_trie_build(&trie, &snap);
+    timing_end(&timings.group_ms, start); // indexing is this mode's grouping step
+    int missed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(queries[i], "-") == 0) {
+            struct owner_index ix = { &trie, &snap };
+            out_flush(&stdout_buf);
+            missed |= stdin_lines(owner_answer, &ix);
+        } else {
+            double q = timing_begin();
+            if (owner_query(&stdout_buf, &trie, &snap, queries[i]) != 0) missed = 1;
+            timing_end(&timings.format_ms, q);
+        }
+    }
+    snapshot_release(&snap); // trie nodes included
+    return missed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#define DAEMON_MAGIC "IFSHOWD1" // first word of --daemon requests and replies; bump on protocol changes
+#define DAEMON_LINE_MAX 128     // longest request or reply header line
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0          // macOS: a dead peer then raises SIGPIPE, which the daemon ignores
+#endif
+
+static const char *const format_names[] = { "text", "json", "ndjson", "openmetrics", "bin" }; // by enum output_format
+
+/**
+ * @brief Look an output format up by name.
+ *
+ * @param name  Format name, as given to --format.
+ * @return The format, or -1 if unknown.
+ */
+static int format_parse(const char *name) {
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); ++i) {
+        if (strcmp(name, format_names[i]) == 0) return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Fill a unix socket address.
+ *
+ * @param sun   Address to fill.
+ * @param path  Socket path.
+ * @return 0, or -1 (ENAMETOOLONG) if the path does not fit.
+ */
+static int unix_address(struct sockaddr_un *sun, const char *path) {
+    memset(sun, 0, sizeof(*sun));
+    sun->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(sun->sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(sun->sun_path, path, strlen(path));
+    return 0;
+}
+
+/**
+ * @brief Send a whole buffer on a socket.
+ *
+ * @return 0 on success; -1 on failure (errno set).
+ */
+static int send_all(int fd, const void *data, size_t len) {
+    const char *p = data;
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read one newline-terminated line from a socket, byte by byte.
+ *
+ * Only used for the short request and header lines, so nothing past the
+ * newline is consumed.
+ *
+ * @param fd    Socket.
+ * @param line  Receives the line, NUL-terminated, without its newline.
+ * @param cap   Size of `line`.
+ * @return 0 on success; -1 on failure, end of stream (ECONNRESET) or an overlong line (EMSGSIZE).
+ */
+static int recv_line(int fd, char *line, size_t cap) {
+    for (size_t len = 0; len + 1 < cap;) {
+        ssize_t n = recv(fd, line + len, 1, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (line[len] == '\n') {
+            line[len] = '\0';
+            return 0;
+        }
+        len++;
+    }
+    errno = EMSGSIZE;
+    return -1;
+}
+
+/**
+ * @brief Print `-a` as rendered by an `ifshow --daemon` (--via).
+ *
+ * Sends "IFSHOWD1 <format>", reads "IFSHOWD1 <length>" and copies the
+ * document into the stdout buffer. Exits the process on failure.
+ *
+ * @param path  Daemon socket.
+ * @return `EXIT_SUCCESS`.
+ */
+static int show_via(const char *path) {
+    struct sockaddr_un sun;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || unix_address(&sun, path) != 0 || connect(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    double start = timing_begin();
+    char line[DAEMON_LINE_MAX];
+    int n = snprintf(line, sizeof(line), DAEMON_MAGIC " %s\n", format_names[output_format]);
+    if (send_all(fd, line, (size_t)n) != 0 || recv_line(fd, line, sizeof(line)) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    unsigned long long len;
+    char end;
+    if (strncmp(line, DAEMON_MAGIC " error ", sizeof(DAEMON_MAGIC " error ") - 1) == 0) {
+        fprintf(stderr, "ifshow: %s: %s\n", path, line + sizeof(DAEMON_MAGIC " error ") - 1);
+        exit(EXIT_FAILURE);
+    }
+    if (sscanf(line, DAEMON_MAGIC " %llu%c", &len, &end) != 1) {
+        fprintf(stderr, "ifshow: %s: not an ifshow daemon\n", path);
+        exit(EXIT_FAILURE);
+    }
+    while (len) {
+        size_t want = len < 65536 ? (size_t)len : 65536;
+        ssize_t got = recv(fd, out_reserve(&stdout_buf, want), want, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            if (got == 0) errno = ECONNRESET; // the daemon went away mid-document
+            perror(path);
+            exit(EXIT_FAILURE);
+        }
+        stdout_buf.len += (size_t)got;
+        len -= (unsigned long long)got;
+    }
+    close(fd);
+    timing_end(&timings.enumerate_ms, start); // the daemon's round-trip stands in for the dump
+    return EXIT_SUCCESS;
+}
+
+#ifdef __linux__
+
+/**
+ * @brief One address remembered by watch mode.
+ */
+struct watch_entry {
+    char name[IF_NAMESIZE];     // name when added, still known once the device is gone
+    unsigned int ifindex;
+    int family;
+    int prefix;
+    unsigned char addr[16];
+    unsigned char state;        // WATCH_EMPTY, WATCH_USED or WATCH_DELETED
+};
+
+enum { WATCH_EMPTY, WATCH_USED, WATCH_DELETED };
+
+/**
+ * @brief Open-addressing set of the addresses currently present.
+ *
+ * Keyed on (ifindex, family, prefix, address) so the RTM_NEWADDR refreshes the
+ * kernel sends for already known addresses (lifetimes, DAD) are not
+ * reported as additions.
+ */
+struct watch_set {
+    struct watch_entry *slots;
+    size_t cap;         // slot count, power of two (0 before first insert)
+    size_t used;        // WATCH_USED slots
+    size_t filled;      // WATCH_USED + WATCH_DELETED slots
+};
+
+/**
+ * @brief Hash the identity of an address (everything but its name).
+ *
+ * @param ai  Address.
+ * @return 32-bit FNV-1a hash.
+ */
+static uint32_t watch_hash(const struct addr_info *ai) {
+    unsigned char key[4 + 2 + 16];
+    size_t alen = ai->family == AF_INET ? 4 : 16;
+    memcpy(key, &ai->ifindex, 4);
+    key[4] = (unsigned char)ai->family;
+    key[5] = (unsigned char)ai->prefix;
+    memcpy(key + 6, ai->addr, alen);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < 6 + alen; ++i) {
+        h ^= key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Tell whether a set entry holds the same address as `ai`.
+ */
+static int watch_entry_matches(const struct watch_entry *e, const struct addr_info *ai) {
+    return e->ifindex == ai->ifindex && e->family == ai->family && e->prefix == ai->prefix &&
+           memcmp(e->addr, ai->addr, ai->family == AF_INET ? 4 : 16) == 0;
+}
+
+/**
+ * @brief Find the slot holding `ai`, or NULL.
+ */
+static struct watch_entry *watch_set_find(const struct watch_set *set, const struct addr_info *ai) {
+    if (!set->cap) return NULL;
+    size_t mask = set->cap - 1;
+    for (size_t i = watch_hash(ai) & mask;; i = (i + 1) & mask) {
+        struct watch_entry *e = &set->slots[i];
+        if (e->state == WATCH_EMPTY) return NULL;
+        if (e->state == WATCH_USED && watch_entry_matches(e, ai)) return e;
+    }
+}
+
+/**
+ * @brief Insert an address unless it is already present.
+ *
+ * @param set  Set to update.
+ * @param ai   Address to insert (its name is copied).
+ * @return 1 if the address is new; 0 if it was already known.
  */
+static int watch_set_add(struct watch_set *set, const struct addr_info *ai) {
+    if (watch_set_find(set, ai)) return 0;
+    if ((set->filled + 1) * 2 > set->cap) { // rehash (dropping tombstones), growing if mostly live
+        struct watch_set grown = { .cap = set->cap ? set->cap : 64 };
+        while ((set->used + 1) * 2 > grown.cap / 2) grown.cap *= 2;
+        grown.slots = xrealloc(NULL, grown.cap * sizeof(*grown.slots));
+        memset(grown.slots, 0, grown.cap * sizeof(*grown.slots));
+        for (size_t i = 0; i < set->cap; ++i) {
+            const struct watch_entry *e = &set->slots[i];
+            if (e->state != WATCH_USED) continue;
+            struct addr_info key = { .ifindex = e->ifindex, .family = e->family, .prefix = e->prefix };
+            memcpy(key.addr, e->addr, sizeof(key.addr));
+            size_t j = watch_hash(&key) & (grown.cap - 1);
+            while (grown.slots[j].state != WATCH_EMPTY) j = (j + 1) & (grown.cap - 1);
+            grown.slots[j] = *e;
+        }
+        grown.used = grown.filled = set->used;
+        free(set->slots);
+        *set = grown;
+    }
+    size_t mask = set->cap - 1;
+    size_t i = watch_hash(ai) & mask;
+    while (set->slots[i].state == WATCH_USED) i = (i + 1) & mask;
+    struct watch_entry *e = &set->slots[i];
+    if (e->state == WATCH_EMPTY) set->filled++;
+    snprintf(e->name, sizeof(e->name), "%s", ai->ifname);
+    e->ifindex = ai->ifindex;
+    e->family = ai->family;
+    e->prefix = ai->prefix;
+    memcpy(e->addr, ai->addr, sizeof(e->addr));
+    e->state = WATCH_USED;
+    set->used++;
+    return 1;
+}
 
-#include <ifaddrs.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <sys/socket.h>
-#include <netdb.h>
-#include <string.h>
-#include <arpa/inet.h>
+/**
+ * @brief Rebuild an `addr_info` view of a set entry.
+ *
+ * @param e   Set entry.
+ * @param ai  Receives the address; `ai->ifname` points into `e`.
+ */
+static void watch_entry_info(const struct watch_entry *e, struct addr_info *ai) {
+    ai->ifname = e->name;
+    ai->ifindex = e->ifindex;
+    ai->family = e->family;
+    ai->prefix = e->prefix;
+    ai->scope = addr_scope_of(e->family, e->addr);
+    memcpy(ai->addr, e->addr, sizeof(ai->addr));
+}
+
+/**
+ * @brief Take a snapshot and fill a known set from it.
+ *
+ * @param snap           Snapshot to fill (zeroed), kept for the grouped output.
+ * @param set            Known set to fill (zeroed).
+ * @param target_ifname  Interface filter, or NULL.
+ */
+static void watch_snapshot(struct snapshot *snap, struct watch_set *set, const char *target_ifname) {
+    enumerate_addresses(target_ifname, snapshot_add, snap);
+    struct addr_info ai;
+    for (uint32_t i = 0; i < snap->addr_count; ++i) {
+        snapshot_addr_info(snap, &snap->addrs[i], &ai);
+        watch_set_add(set, &ai);
+    }
+}
+
+/**
+ * @brief Re-dump the addresses after lost events and report the differences.
+ *
+ * @param p              Printer receiving the change events.
+ * @param known          Known set, replaced by the fresh one.
+ * @param target_ifname  Interface filter, or NULL.
+ */
+static void watch_resync(struct printer *p, struct watch_set *known, const char *target_ifname) {
+    struct snapshot snap = {0};
+    struct watch_set now = {0};
+    watch_snapshot(&snap, &now, target_ifname);
+    snapshot_free(&snap);
+    struct addr_info ai;
+    for (size_t i = 0; i < known->cap; ++i) {
+        if (known->slots[i].state != WATCH_USED) continue;
+        watch_entry_info(&known->slots[i], &ai);
+        if (!watch_set_find(&now, &ai)) p->ops->event(p, '-', &ai);
+    }
+    for (size_t i = 0; i < now.cap; ++i) {
+        if (now.slots[i].state != WATCH_USED) continue;
+        watch_entry_info(&now.slots[i], &ai);
+        if (!watch_set_find(known, &ai)) p->ops->event(p, '+', &ai);
+    }
+    free(known->slots);
+    *known = now;
+}
+
+/**
+ * @brief Open a netlink socket subscribed to RTNLGRP_IPV4_IFADDR and RTNLGRP_IPV6_IFADDR.
+ *
+ * Subscribe before taking a snapshot so no change falls in between. Exits
+ * the process on failure.
+ *
+ * @param ev  Socket to open.
+ */
+static void addr_events_open(struct nl_sock *ev) {
+    if (nl_open(ev) != 0) {
+        perror("netlink");
+        exit(EXIT_FAILURE);
+    }
+    const int groups[] = { RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR };
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); ++i) {
+        if (setsockopt(ev->fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &groups[i], sizeof(groups[i])) != 0) {
+            perror("netlink");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
 
 /**
- * @brief Convert a socket address to a numeric host string.
+ * @brief Print the current addresses, then follow netlink address events forever.
  *
- * Converts an IPv4 or IPv6 `sockaddr` to its numeric string representation
- * using `inet_ntop` (no DNS lookups involved).
+ * Subscribes to RTNLGRP_IPV4_IFADDR and RTNLGRP_IPV6_IFADDR before taking the
+ * snapshot so nothing is missed in between, prints the snapshot in the usual
+ * format, then one "+"/"-" line (or NDJSON event) per address added or removed. Blocks
+ * in `recv` while nothing changes. Exits the process on netlink failure.
  *
- * @param sa      Pointer to source socket address (IPv4/IPv6). Must not be NULL.
- * @param buf     Output buffer to receive the numeric host string.
- * @param buflen  Size (in bytes) of the output buffer.
- * @return 0 on success; -1 on failure (NULL args, unsupported family, or buffer too small).
+ * @param target_ifname  Only watch this interface (or alias), or NULL for all.
  */
-static int addr_to_string(const struct sockaddr *sa, char *buf, size_t buflen) {
-    if (!sa || !buf || buflen == 0) return -1;
-    switch (sa->sa_family) {
-        case AF_INET: {
-            const struct sockaddr_in *sin = (const struct sockaddr_in *)sa;
-            return inet_ntop(AF_INET, &sin->sin_addr, buf, (socklen_t)buflen) ? 0 : -1;
+static void watch_addresses(const char *target_ifname) {
+    struct nl_sock ev;
+    addr_events_open(&ev);
+
+    struct outbuf *ob = &stdout_buf;
+    struct printer p = printer_open(ob, target_ifname != NULL);
+    struct snapshot snap = {0};
+    struct watch_set known = {0};
+    watch_snapshot(&snap, &known, target_ifname);
+    snapshot_sort(&snap, sort_order);
+    if (target_ifname) { // same output as show_single_interface()
+        print_single_group(&p, target_ifname, &snap);
+    } else {
+        print_groups(&p, &snap);
+    }
+    snapshot_free(&snap);
+
+    struct nl_addr_walk w = { .nl = &ev }; // no filter here: removals are matched against `known`
+    for (;;) {
+        if (out_flush(ob) != 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
         }
-        case AF_INET6: {
-            const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)sa;
-            return inet_ntop(AF_INET6, &sin6->sin6_addr, buf, (socklen_t)buflen) ? 0 : -1;
+        ssize_t n = recv(ev.fd, ev.buf, NL_BUFSIZE, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) { // the kernel dropped events: start over from a fresh dump
+                fprintf(stderr, "ifshow: address events lost, resynchronizing\n");
+                watch_resync(&p, &known, target_ifname);
+                continue;
+            }
+            perror("netlink");
+            exit(EXIT_FAILURE);
+        }
+        int len = (int)n;
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)ev.buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != RTM_NEWADDR && nlh->nlmsg_type != RTM_DELADDR) continue;
+            w.name_index = 0; // devices may have been renamed or replaced since the last event
+            struct addr_info ai;
+            if (nl_parse_addr(&w, nlh, &ai) != 0) continue;
+            if (nlh->nlmsg_type == RTM_NEWADDR) {
+                if (target_ifname && strcmp(ai.ifname, target_ifname) != 0) continue;
+                if (!addr_filter_match(&addr_filter, &ai)) continue;
+                if (watch_set_add(&known, &ai)) p.ops->event(&p, '+', &ai);
+            } else {
+                struct watch_entry *e = watch_set_find(&known, &ai);
+                if (!e) continue; // not watched (or never seen)
+                struct addr_info gone;
+                watch_entry_info(e, &gone); // the name it had, the device may already be gone
+                p.ops->event(&p, '-', &gone);
+                e->state = WATCH_DELETED;
+                known.used--;
+            }
         }
-        default:
-            return -1;
     }
 }
 
 /**
- * @brief Compute CIDR prefix length from a netmask sockaddr.
+ * @brief Block until every named interface has a matching address, then print them (--wait).
  *
- * Supports IPv4 and IPv6 netmasks. For IPv4, counts leading 1-bits in the
- * 32-bit mask. For IPv6, counts leading 1-bits across the 128-bit mask.
+ * Subscribes to address events, checks once like --exists does, then only
+ * wakes up for notifications: each added address that passes the filters is
+ * counted, and a removal from an interface already satisfied (or lost events)
+ * triggers a fresh check. Once satisfied, prints what `-i` would. Exits the
+ * process on netlink failure.
  *
- * @param netmask  Pointer to a netmask `sockaddr` (AF_INET or AF_INET6).
- * @return Prefix length (0..32 for IPv4, 0..128 for IPv6), or -1 if `netmask`
- *         is NULL or the address family is unsupported.
+ * @param names       -i names.
+ * @param count       Number of names (>= 1).
+ * @param timeout_ms  Give up after this long, or -1 to wait forever.
+ * @return `EXIT_SUCCESS` once every name has an address; `EXIT_FAILURE` on timeout.
  */
-static int count_prefix_length(const struct sockaddr *netmask) {
-    if (!netmask) return -1; // error on netmask undefined
-    if (netmask->sa_family == AF_INET) { // if v4
-        const struct sockaddr_in *nm4 = (const struct sockaddr_in *)netmask; // set nm4 to netmask from struct 
-        uint32_t m = ntohl(nm4->sin_addr.s_addr); // network to host byte order 
-        int count = 0;
-        for (int i = 31; i >= 0; --i) { // start from 31 because network masks starts from 32
-            if ((m >> i) & 1U) count++; else break; // stop at first 0 from MSB, because first 0 is forcibly the end of mask
+static int wait_for_addresses(const char *const *names, size_t count, long timeout_ms) {
+    struct nl_sock ev;
+    addr_events_open(&ev);
+    double deadline = monotonic_ms() + (double)timeout_ms;
+    struct count_table t = {0};
+    count_table_fill(&t, names, count, 1);
+    struct nl_addr_walk w = { .nl = &ev };
+    while (t.missing) {
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            double left = deadline - monotonic_ms();
+            if (left <= 0) break;
+            wait_ms = (int)left + 1; // poll() rounds down
+        }
+        struct pollfd pfd = { .fd = ev.fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            exit(EXIT_FAILURE);
         }
-        return count;
-    } else if (netmask->sa_family == AF_INET6) { //else v6
-        const struct sockaddr_in6 *nm6 = (const struct sockaddr_in6 *)netmask;
-        int count = 0;
-        for (int i = 0; i < 16; ++i) {
-            unsigned char b = nm6->sin6_addr.s6_addr[i];                              // This one was designed by AI
-            for (int bit = 7; bit >= 0; --bit) {
-                if ((b >> bit) & 1U) count++; else return count; // stop at first 0
+        if (ready <= 0) continue;
+        int recheck = 0;
+        ssize_t n = recv(ev.fd, ev.buf, NL_BUFSIZE, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == ENOBUFS) {
+                recheck = 1; // events were dropped
+            } else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("netlink");
+                exit(EXIT_FAILURE);
             }
         }
-        return count;
+        int len = n > 0 ? (int)n : 0;
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)ev.buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != RTM_NEWADDR && nlh->nlmsg_type != RTM_DELADDR) continue;
+            w.name_index = 0; // devices may have been renamed or replaced since the last event
+            struct addr_info ai;
+            if (nl_parse_addr(&w, nlh, &ai) != 0 || !addr_filter_match(&addr_filter, &ai)) continue;
+            if (nlh->nlmsg_type == RTM_NEWADDR) {
+                count_visit(&ai, &t);
+                continue;
+            }
+            uint32_t name = snapshot_find(&t.names, ai.ifname);
+            if (name != SNAP_NONE && (t.entries[name].inet || t.entries[name].inet6)) recheck = 1; // it may have been the last one
+        }
+        if (recheck) {
+            count_table_free(&t);
+            t = (struct count_table){0};
+            count_table_fill(&t, names, count, 1);
+        }
     }
-    return -1;
+    int found = t.missing == 0;
+    if (!found) {
+        for (uint32_t i = 0; i < t.names.name_count; ++i) {
+            if (t.entries[i].inet || t.entries[i].inet6) continue;
+            fprintf(stderr, "ifshow: timed out waiting for an address on '%s'\n", t.names.names[i].name);
+            break;
+        }
+    }
+    count_table_free(&t);
+    nl_close(&ev);
+    if (!found) return EXIT_FAILURE;
+    show_interfaces(names, count);
+    return EXIT_SUCCESS;
 }
 
-// (previous single-line formatter removed in favor of grouped bullet output)
+#define SERVE_MAX_WORDS 256 // words of one --serve-stdin query, command included
 
 /**
- * @brief Print CLI usage instructions to stdout.
+ * @brief What --serve-stdin keeps between queries.
  *
- * Describes available options and examples for using the program. Does not
- * exit; callers decide flow control.
+ * One socket for the dumps, one subscribed to address events: any event
+ * (or a lost one) marks the snapshot stale, and it is re-dumped before the
+ * next query. The --owner index is built on the first `owner` query after
+ * each refresh.
  */
-void help() {
-    printf("Usage:\n");
-    printf("  ifshow -a                     # Show all interfaces\n");
-    printf("  ifshow -i <interface_name>    # Show specific interface\n");
-    printf("\nExamples:\n");
-    printf("  ifshow -a\n");
-    printf("  ifshow -i eth0\n");
-    printf("\nNotes:\n");
-    printf("  Addresses include netmask as address/prefix.\n");
-    printf("  IPv4 also shows dotted mask in parentheses.\n\n");
+struct serve_cache {
+    struct nl_sock dump;        // RTM_GETADDR dumps, reused for every refresh
+    struct nl_sock events;      // RTNLGRP_IPV4_IFADDR / RTNLGRP_IPV6_IFADDR member
+    struct snapshot snap;       // sorted and grouped
+    struct prefix_trie trie;    // in the snapshot's arena, valid when `indexed`
+    int indexed;
+    int stale;                  // an address event arrived since the last dump
+};
+
+/**
+ * @brief Re-dump the addresses into the cached snapshot.
+ *
+ * Exits the process on netlink failure.
+ *
+ * @param c  Cache to refresh.
+ */
+static void serve_refresh(struct serve_cache *c) {
+    snapshot_free(&c->snap); // trie nodes included
+    c->snap = (struct snapshot){0};
+    c->trie = (struct prefix_trie){0};
+    c->indexed = 0;
+    c->stale = 0;
+    if (enumerate_with(BACKEND_NETLINK, &c->dump, &addr_filter, NULL, snapshot_add, &c->snap, NULL) != 0) {
+        perror("netlink");
+        exit(EXIT_FAILURE);
+    }
+    double start = timing_begin();
+    snapshot_sort(&c->snap, sort_order);
+    snapshot_group(&c->snap);
+    timing_end(&timings.group_ms, start);
+}
+
+/**
+ * @brief Read the pending address events without blocking and note whether any arrived.
+ *
+ * The kernel queues an event before it acknowledges the change, so a change
+ * made before a query was sent is always seen here. Exits the process on
+ * netlink failure.
+ *
+ * @param c  Cache whose `stale` flag is updated.
+ */
+static void serve_poll(struct serve_cache *c) {
+    for (;;) {
+        ssize_t n = recv(c->events.fd, c->events.buf, NL_BUFSIZE, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == ENOBUFS) { // events were dropped: whatever they said, the snapshot is old
+                c->stale = 1;
+                continue;
+            }
+            perror("netlink");
+            exit(EXIT_FAILURE);
+        }
+        int len = (int)n;
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)c->events.buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_DELADDR) c->stale = 1;
+        }
+    }
+}
+
+/**
+ * @brief Answer a malformed query.
+ *
+ * @param ob   Output buffer.
+ * @param msg  Message, without trailing newline.
+ */
+static void serve_error(struct outbuf *ob, const char *msg) {
+    if (output_format == FORMAT_TEXT) {
+        out_puts(ob, "error: ");
+        out_puts(ob, msg);
+        out_puts(ob, "\n");
+        return;
+    }
+    out_puts(ob, "{\"error\":");
+    json_string(ob, msg);
+    out_puts(ob, "}\n");
+}
+
+/**
+ * @brief A requested name and where `show` prints it.
+ */
+struct serve_name {
+    uint32_t rank;      // request order, or with --sort the cached snapshot's (missing names last)
+    uint32_t name;      // index in the cached snapshot, or SNAP_NONE
+    const char *ifname;
+};
+
+/**
+ * @brief qsort order of `struct serve_name`.
+ */
+static int serve_name_cmp(const void *a, const void *b) {
+    const struct serve_name *x = a, *y = b;
+    return (x->rank > y->rank) - (x->rank < y->rank);
 }
 
 /**
- * @brief Print an interface header line.
+ * @brief `show [<name>...]`: the output of `-a`, or of `-i <name>...`, from the cache.
  *
- * Prints the interface name followed by a colon (e.g., "eth0:") if the
- * provided name is non-empty.
+ * The cached snapshot is already sorted, so with --sort the requested names
+ * follow its order (names without addresses last), as a one-shot `-i` would.
+ *
+ * @param c      Cache.
+ * @param names  Interface names (duplicates collapse onto the first).
+ * @param count  Number of names, 0 for every interface.
+ */
+static void serve_show(struct serve_cache *c, char **names, size_t count) {
+    if (!count) {
+        struct printer p = printer_open(&stdout_buf, 0);
+        print_snapshot(&p, &c->snap, 0);
+        return;
+    }
+    struct snapshot req = {0};
+    for (size_t i = 0; i < count; ++i) snapshot_intern(&req, names[i]);
+    struct serve_name *shown = xrealloc(NULL, req.name_count * sizeof(*shown));
+    for (uint32_t i = 0; i < req.name_count; ++i) {
+        uint32_t name = snapshot_find(&c->snap, req.names[i].name);
+        uint32_t rank = sort_order == SORT_NONE || name == SNAP_NONE ? c->snap.name_count + i : name;
+        shown[i] = (struct serve_name){ rank, name, req.names[i].name };
+    }
+    if (sort_order != SORT_NONE) qsort(shown, req.name_count, sizeof(*shown), serve_name_cmp);
+    struct printer p = printer_open(&stdout_buf, req.name_count == 1);
+    p.ops->begin(&p);
+    for (uint32_t i = 0; i < req.name_count; ++i) print_snapshot_group(&p, shown[i].ifname, &c->snap, shown[i].name);
+    p.ops->end(&p);
+    free(shown);
+    snapshot_free(&req);
+}
+
+/**
+ * @brief `count` / `exists`: fill a count table from the cached addresses.
  *
- * @param ifname  Interface name string. May be NULL or empty; prints nothing.
+ * @param c                Cache.
+ * @param t                Zeroed table.
+ * @param names            Interface names, or NULL for every interface.
+ * @param count            Number of names.
+ * @param stop_when_found  `exists`: stop once every name has an address.
  */
-static void print_interface_header(const char *ifname) {
-    if (ifname && *ifname) {
-        printf("%s:\n", ifname);
+static void serve_count(struct serve_cache *c, struct count_table *t, char **names, size_t count, int stop_when_found) {
+    count_table_seed(t, (const char *const *)names, count, stop_when_found);
+    struct addr_info ai;
+    for (uint32_t i = 0; i < c->snap.addr_count; ++i) {
+        snapshot_addr_info(&c->snap, &c->snap.addrs[i], &ai);
+        if (count_visit(&ai, t)) break;
     }
 }
 
 /**
- * @brief Print a bullet line for an address.
+ * @brief stdin_lines() callback: answer one --serve-stdin query.
  *
- * Renders a line in the form " - <addr>/<prefix>". For IPv4, also prints the
- * dotted mask in parentheses, " - 192.0.2.10/24 (255.255.255.0)".
+ * Queries are whitespace-separated words (interface names may also be
+ * comma-separated): `show [<name>...]`, `owner <ip>...`, `count [<name>...]`
+ * and `exists <name>...`. Each answer is what the matching one-shot mode
+ * prints, followed by a "." line (`{"end":true}` in JSON formats) so a
+ * client knows where it stops.
  *
- * @param addr     Pointer to the address `sockaddr` (IPv4 or IPv6). If NULL, no output.
- * @param netmask  Optional pointer to the netmask `sockaddr` used to compute
- *                 the prefix length. May be NULL.
+ * @param line  Query.
+ * @param ctx   `struct serve_cache`.
+ * @return 1 for a malformed query, 0 otherwise.
  */
-static void print_address_bullet(const struct sockaddr *addr, const struct sockaddr *netmask) {
-    if (!addr) return;
-    char addr_str[NI_MAXHOST] = {0};
-    char mask_str[NI_MAXHOST] = {0};
-    int family = addr->sa_family;
-    if (addr_to_string(addr, addr_str, sizeof(addr_str)) != 0) return;
-    int prefix = count_prefix_length(netmask);
-    if (family == AF_INET && netmask && addr_to_string(netmask, mask_str, sizeof(mask_str)) == 0 && prefix >= 0) {
-        printf(" - %s/%d (%s)\n", addr_str, prefix, mask_str);
-    } else if (prefix >= 0) {
-        printf(" - %s/%d\n", addr_str, prefix);
+static int serve_answer(char *line, void *ctx) {
+    struct serve_cache *c = ctx;
+    struct outbuf *ob = &stdout_buf;
+    serve_poll(c);
+    if (c->stale) serve_refresh(c);
+
+    double start = timing_begin();
+    char *words[SERVE_MAX_WORDS], *save = NULL;
+    size_t n = 0;
+    int bad = 0;
+    for (char *w = strtok_r(line, " \t,", &save); w; w = strtok_r(NULL, " \t,", &save)) {
+        if (n == SERVE_MAX_WORDS) {
+            bad = 1;
+            break;
+        }
+        words[n++] = w;
+    }
+    const char *cmd = n ? words[0] : ""; // a line of commas has no words
+    char **args = words + 1;
+    size_t argn = n ? n - 1 : 0;
+    if (bad) {
+        serve_error(ob, "too many words in query");
+    } else if (strcmp(cmd, "show") == 0) {
+        serve_show(c, args, argn);
+    } else if (strcmp(cmd, "owner") == 0 && argn) {
+        if (!c->indexed) {
+            prefix_trie_build(&c->trie, &c->snap);
+            c->indexed = 1;
+        }
+        for (size_t i = 0; i < argn; ++i) {
+            if (owner_query(ob, &c->trie, &c->snap, args[i]) < 0) {
+                char msg[128];
+                snprintf(msg, sizeof(msg), "not an IP address: '%.64s'", args[i]);
+                serve_error(ob, msg);
+                bad = 1;
+            }
+        }
+    } else if (strcmp(cmd, "count") == 0) {
+        struct count_table t = {0};
+        serve_count(c, &t, argn ? args : NULL, argn, 0);
+        print_counts(ob, &t);
+        count_table_free(&t);
+    } else if (strcmp(cmd, "exists") == 0 && argn) {
+        struct count_table t = {0};
+        serve_count(c, &t, args, argn, 1);
+        if (output_format == FORMAT_TEXT) {
+            out_puts(ob, t.missing == 0 ? "yes\n" : "no\n");
+        } else {
+            out_puts(ob, t.missing == 0 ? "{\"exists\":true}\n" : "{\"exists\":false}\n");
+        }
+        count_table_free(&t);
     } else {
-        printf(" - %s\n", addr_str);
+        serve_error(ob, "expected 'show [<name>...]', 'owner <ip>...', 'count [<name>...]' or 'exists <name>...'");
+        bad = 1;
     }
+    out_puts(ob, output_format == FORMAT_TEXT ? ".\n" : "{\"end\":true}\n");
+    timing_end(&timings.format_ms, start);
+    return bad;
 }
 
 /**
- * @brief Enumerate and display all interfaces with their IP addresses.
+ * @brief Answer line-delimited queries from stdin off one cached snapshot (--serve-stdin).
+ *
+ * Subscribes to address events before the first dump, like watch_addresses(),
+ * then only re-dumps when an event reports a change. Answers are flushed once
+ * per chunk of input read. Exits the process on netlink failure.
  *
- * Uses `getifaddrs` to collect interface entries, groups them by interface
- * name, and prints IPv4/IPv6 addresses with prefixes. Exits the process on
- * `getifaddrs` failure.
+ * @return `EXIT_SUCCESS` at end of input.
  */
-static void show_all_interfaces(void) {
-    struct ifaddrs *ifaddr = NULL;
-    if (getifaddrs(&ifaddr) == -1) {
-        perror("getifaddrs");
+static int serve_stdin(void) {
+    struct serve_cache c = {0};
+    addr_events_open(&c.events);
+    if (nl_open(&c.dump) != 0) {
+        perror("netlink");
         exit(EXIT_FAILURE);
     }
+    serve_refresh(&c);
+    stdin_lines(serve_answer, &c);
+    snapshot_free(&c.snap);
+    nl_close(&c.dump);
+    nl_close(&c.events);
+    return EXIT_SUCCESS;
+}
 
-    // Collect unique interface names with IP addresses (simple fixed-size list to stay lightweight).
-    const int MAX_IFS = 256;
-    const char *names[MAX_IFS];
-    int name_count = 0;
+static volatile sig_atomic_t daemon_stop; // --daemon: SIGINT or SIGTERM received
 
-    for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = (*ifa).ifa_next) {
-        if (!ifa || !(*ifa).ifa_addr) continue;
-        int family = (*ifa).ifa_addr->sa_family;
-        if (family != AF_INET && family != AF_INET6) continue;
-        // Check if name already recorded
-        int seen = 0;
-        for (int i = 0; i < name_count; ++i) {
-            if (strcmp(names[i], (*ifa).ifa_name) == 0) { seen = 1; break; } // set seen=1 if name from table and ifa_name are the same
-        }
-        if (!seen && name_count < MAX_IFS) { // copare to fixed size to verify we arent having a 800 line output...
-            names[name_count++] = (*ifa).ifa_name; // pointer valid while ifaddr is alive
+/**
+ * @brief SIGINT/SIGTERM handler of --daemon: leave the accept loop.
+ */
+static void daemon_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+/**
+ * @brief Tell whether a unix socket file is only left over from a dead daemon.
+ *
+ * @param sun  Socket address.
+ * @return 1 if connecting is refused; 0 if something answers (or the probe fails otherwise).
+ */
+static int unix_socket_stale(const struct sockaddr_un *sun) {
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) return 0;
+    int stale = connect(probe, (const struct sockaddr *)sun, sizeof(*sun)) != 0 && errno == ECONNREFUSED;
+    close(probe);
+    return stale;
+}
+
+/**
+ * @brief Bind and listen on a unix socket, replacing a stale socket file.
+ *
+ * A path another daemon still answers on is left alone. Exits the process
+ * on failure.
+ *
+ * @param path  Socket path.
+ * @return Listening socket.
+ */
+static int daemon_listen(const char *path) {
+    struct sockaddr_un sun;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || unix_address(&sun, path) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    int rc = bind(fd, (struct sockaddr *)&sun, sizeof(sun));
+    if (rc != 0 && errno == EADDRINUSE) {
+        if (unix_socket_stale(&sun)) {
+            unlink(path);
+            rc = bind(fd, (struct sockaddr *)&sun, sizeof(sun));
+        } else {
+            errno = EADDRINUSE; // another daemon serves it
         }
     }
+    if (rc != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+/**
+ * @brief One pre-rendered --daemon reply.
+ */
+struct daemon_reply {
+    struct outbuf body;     // memory only
+    int ready;              // rendered from the current snapshot
+};
+
+/**
+ * @brief Answer one --via client, then close its connection.
+ *
+ * Re-dumps the snapshot first if an address event arrived, and renders the
+ * requested format only once per snapshot. A client that does not send its
+ * request (or read the reply) within a second is dropped.
+ *
+ * @param c        Cache.
+ * @param replies  Replies by format.
+ * @param fd       Accepted connection.
+ */
+static void daemon_answer(struct serve_cache *c, struct daemon_reply *replies, int fd) {
+    struct timeval tv = { .tv_sec = 1 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    char line[DAEMON_LINE_MAX];
+    if (recv_line(fd, line, sizeof(line)) != 0) {
+        close(fd);
+        return;
+    }
+    int format = strncmp(line, DAEMON_MAGIC " ", sizeof(DAEMON_MAGIC)) == 0 ? format_parse(line + sizeof(DAEMON_MAGIC)) : -1;
+    if (format < 0) {
+        static const char bad[] = DAEMON_MAGIC " error unknown request\n";
+        send_all(fd, bad, sizeof(bad) - 1);
+        close(fd);
+        return;
+    }
+    serve_poll(c);
+    if (c->stale) {
+        serve_refresh(c);
+        for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); ++i) replies[i].ready = 0;
+    }
+    struct daemon_reply *r = &replies[format];
+    if (!r->ready) {
+        struct printer p = { .ops = printer_ops_for((enum output_format)format), .ob = &r->body };
+        r->body.len = 0;
+        double start = timing_begin();
+        print_snapshot(&p, &c->snap, 0);
+        timing_end(&timings.format_ms, start);
+        r->ready = 1;
+    }
+    int n = snprintf(line, sizeof(line), DAEMON_MAGIC " %zu\n", r->body.len);
+    if (send_all(fd, line, (size_t)n) == 0) send_all(fd, r->body.data, r->body.len); // a vanished client is its own problem
+    close(fd);
+}
+
+/**
+ * @brief Serve `-a` from an event-updated snapshot on a unix socket (--daemon).
+ *
+ * Subscribes to address events like watch_addresses() and takes one dump;
+ * each event marks the snapshot stale and the next request re-dumps it.
+ * Every format is rendered at most once per snapshot and replayed from
+ * memory. Stops on SIGINT or SIGTERM and removes the socket. Exits the
+ * process on netlink or socket failure.
+ *
+ * @param path  Socket path to listen on.
+ * @return `EXIT_SUCCESS` once stopped by a signal.
+ */
+static int daemon_serve(const char *path) {
+    struct serve_cache c = {0};
+    addr_events_open(&c.events);
+    if (nl_open(&c.dump) != 0) {
+        perror("netlink");
+        exit(EXIT_FAILURE);
+    }
+    c.stale = 1; // the first request dumps
+    struct daemon_reply replies[sizeof(format_names) / sizeof(format_names[0])];
+    for (size_t i = 0; i < sizeof(replies) / sizeof(replies[0]); ++i) replies[i] = (struct daemon_reply){ .body = { .fd = -1 } };
+    int lfd = daemon_listen(path);
 
-    // Print grouped output
-    for (int i = 0; i < name_count; ++i) { //name_count defined just above, allows to then print addr per ifname
-        const char *ifname = names[i]; // work from logic defined on the top (158-170)
-        print_interface_header(ifname); // Prints header, then all addresses linked to this header, depending on the addrfamily
-        for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = (*ifa).ifa_next) {
-            if (!ifa || !(*ifa).ifa_addr) continue;
-            if (strcmp((*ifa).ifa_name, ifname) != 0) continue;
-            int family = (*ifa).ifa_addr->sa_family;
-            if (family == AF_INET || family == AF_INET6) {
-                print_address_bullet((*ifa).ifa_addr, (*ifa).ifa_netmask);
+    struct sigaction sa = { .sa_handler = daemon_signal }; // no SA_RESTART: poll() must return
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct pollfd fds[2] = { { .fd = lfd, .events = POLLIN }, { .fd = c.events.fd, .events = POLLIN } };
+    while (!daemon_stop) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+        if (fds[1].revents) serve_poll(&c); // keep the event queue short, the dump waits for a request
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                daemon_answer(&c, replies, fd);
+            } else if (errno != EINTR && errno != ECONNABORTED) {
+                perror("accept");
             }
         }
-        printf("\n");
     }
+    close(lfd);
+    unlink(path);
+    for (size_t i = 0; i < sizeof(replies) / sizeof(replies[0]); ++i) free(replies[i].body.data);
+    snapshot_free(&c.snap);
+    nl_close(&c.dump);
+    nl_close(&c.events);
+    return EXIT_SUCCESS;
+}
+
+#endif /* __linux__ */
+
+#ifdef __linux__
+
+#define NETNS_RUN_DIR "/var/run/netns"  // where `ip netns add` bind-mounts named namespaces
+#define NETNS_MAX_WORKERS 8
 
-    freeifaddrs(ifaddr);
+/**
+ * @brief One network namespace visited by --all-netns, with its rendered output.
+ */
+struct netns_entry {
+    char name[64];      // "<name>" for named namespaces, "pid:<pid>" for /proc ones
+    char path[280];
+    dev_t dev;          // identity of the namespace, to drop duplicates
+    ino_t ino;
+    long pid;           // -1 for named namespaces
+    struct outbuf out;  // memory-only buffer filled by a worker
+    int err;            // errno of a failed visit, 0 on success
+};
+
+/**
+ * @brief Add one thread's --timings accounting to another's.
+ */
+static void timings_add(struct timings *to, const struct timings *from) {
+    to->enumerate_ms += from->enumerate_ms;
+    to->group_ms += from->group_ms;
+    to->format_ms += from->format_ms;
+    to->output_ms += from->output_ms;
+    to->entries += from->entries;
+    to->interfaces += from->interfaces;
+    to->addresses += from->addresses;
+    to->bytes += from->bytes;
 }
 
 /**
- * @brief Display IP addresses for a specific interface.
+ * @brief Namespaces to visit and the work queue shared by the workers.
+ */
+struct netns_sweep {
+    struct netns_entry *entries;
+    size_t count, cap;
+    atomic_size_t next; // next entry index to hand out
+};
+
+/**
+ * @brief Record a namespace file if it can be stat'ed.
  *
- * Prints IPv4/IPv6 addresses (with prefixes) for the given interface name.
- * If the interface is not found or has no IP addresses, prints a message, not stderr.
- * Exits the process on `getifaddrs` failure.
- * 
- * Looks relly the same as "show_all_interfaces() function detailed above
+ * @param sw    Sweep to append to.
+ * @param name  Display name.
+ * @param path  Namespace file (bind mount or /proc/<pid>/ns/net).
+ * @param pid   Owning pid for /proc entries, -1 for named ones.
+ */
+static void netns_add(struct netns_sweep *sw, const char *name, const char *path, long pid) {
+    struct stat st;
+    if (stat(path, &st) != 0) return; // gone, or not ours to see
+    if (sw->count == sw->cap) {
+        sw->cap = sw->cap ? sw->cap * 2 : 32;
+        sw->entries = xrealloc(sw->entries, sw->cap * sizeof(*sw->entries));
+    }
+    struct netns_entry *e = &sw->entries[sw->count++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->dev = st.st_dev;
+    e->ino = st.st_ino;
+    e->pid = pid;
+    e->out.fd = -1;
+}
+
+/**
+ * @brief qsort order for output: named namespaces by name, then /proc ones by pid.
+ */
+static int netns_cmp_output(const void *a, const void *b) {
+    const struct netns_entry *x = a, *y = b;
+    if ((x->pid < 0) != (y->pid < 0)) return x->pid < 0 ? -1 : 1;
+    if (x->pid < 0) return strcmp(x->name, y->name);
+    return (x->pid > y->pid) - (x->pid < y->pid);
+}
+
+/**
+ * @brief qsort order for de-duplication: by identity, preferred entry first.
+ */
+static int netns_cmp_identity(const void *a, const void *b) {
+    const struct netns_entry *x = a, *y = b;
+    if (x->dev != y->dev) return x->dev < y->dev ? -1 : 1;
+    if (x->ino != y->ino) return x->ino < y->ino ? -1 : 1;
+    return netns_cmp_output(a, b);
+}
+
+/**
+ * @brief Collect the namespaces to visit, without duplicates, in output order.
  *
- * @param target_ifname  Name of the interface to display.
+ * @param sw            Sweep to fill.
+ * @param include_proc  Also scan /proc/<pid>/ns/net (unnamed namespaces of running processes).
  */
-static void show_single_interface(const char *target_ifname) {
-    struct ifaddrs *ifaddr = NULL;
-    if (getifaddrs(&ifaddr) == -1) { //error treatment if getifaddrs fails
-        perror("getifaddrs");
+static void netns_collect(struct netns_sweep *sw, int include_proc) {
+    char path[280];
+    DIR *dir = opendir(NETNS_RUN_DIR);
+    if (dir) {
+        for (struct dirent *de; (de = readdir(dir)) != NULL;) {
+            if (de->d_name[0] == '.') continue;
+            snprintf(path, sizeof(path), "%s/%s", NETNS_RUN_DIR, de->d_name);
+            netns_add(sw, de->d_name, path, -1);
+        }
+        closedir(dir);
+    }
+    if (include_proc && (dir = opendir("/proc")) != NULL) {
+        for (struct dirent *de; (de = readdir(dir)) != NULL;) {
+            char *end;
+            long pid = strtol(de->d_name, &end, 10);
+            if (*end || pid <= 0) continue; // not a process directory
+            char name[32];
+            snprintf(path, sizeof(path), "/proc/%ld/ns/net", pid);
+            snprintf(name, sizeof(name), "pid:%ld", pid);
+            netns_add(sw, name, path, pid);
+        }
+        closedir(dir);
+    }
+
+    // Many processes share a namespace (and named ones also appear under /proc): keep one entry each.
+    qsort(sw->entries, sw->count, sizeof(*sw->entries), netns_cmp_identity);
+    size_t kept = 0;
+    for (size_t i = 0; i < sw->count; ++i) {
+        if (kept && sw->entries[i].dev == sw->entries[kept - 1].dev && sw->entries[i].ino == sw->entries[kept - 1].ino) continue;
+        sw->entries[kept++] = sw->entries[i];
+    }
+    sw->count = kept;
+    qsort(sw->entries, sw->count, sizeof(*sw->entries), netns_cmp_output);
+}
+
+/**
+ * @brief Worker thread: enter namespaces from the queue and render each one.
+ *
+ * `setns` only moves the calling thread, so every worker can sit in a
+ * different namespace; the netlink socket opened by the backend then lives
+ * in that namespace.
+ *
+ * @param arg  `struct netns_sweep`.
+ * @return This thread's --timings accounting (heap copy, freed by the joiner).
+ */
+static void *netns_worker(void *arg) {
+    struct netns_sweep *sw = arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&sw->next, 1);
+        if (i >= sw->count) {
+            struct timings *mine = xrealloc(NULL, sizeof(*mine));
+            *mine = timings;
+            return mine;
+        }
+        struct netns_entry *e = &sw->entries[i];
+        int fd = open(e->path, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0) {
+            e->err = errno;
+            continue;
+        }
+        if (fstat(fd, &st) != 0 || st.st_dev != e->dev || st.st_ino != e->ino) { // pid reused meanwhile
+            e->err = ESRCH;
+        } else if (setns(fd, CLONE_NEWNET) != 0) {
+            e->err = errno;
+        }
+        close(fd);
+        if (e->err) continue;
+        struct printer p = printer_open(&e->out, 0);
+        p.netns = e->name;
+        if (render_all_interfaces(&p) != 0) {
+            e->err = errno;
+            e->out.len = 0;
+        }
+    }
+}
+
+/**
+ * @brief Show all interfaces of every network namespace (--all-netns).
+ *
+ * Namespaces are rendered in parallel on a small pool of threads, each with
+ * its own output buffer, then written in a deterministic order: named
+ * namespaces sorted by name, then process namespaces by pid. Failing
+ * namespaces are reported on stderr and skipped.
+ *
+ * @param include_proc  Also visit namespaces only reachable through /proc/<pid>/ns/net.
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if any namespace could not be shown.
+ */
+static int show_all_netns(int include_proc) {
+    struct netns_sweep sw = {0};
+    netns_collect(&sw, include_proc);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = cpus > 0 ? (size_t)cpus : 1;
+    if (workers > NETNS_MAX_WORKERS) workers = NETNS_MAX_WORKERS;
+    if (workers > sw.count) workers = sw.count;
+    atomic_init(&sw.next, 0);
+    pthread_t threads[NETNS_MAX_WORKERS];
+    size_t started = 0;
+    for (; started < workers; ++started) {
+        if (pthread_create(&threads[started], NULL, netns_worker, &sw) != 0) break;
+    }
+    if (started == 0 && sw.count > 0) {
+        perror("pthread_create");
         exit(EXIT_FAILURE);
     }
+    for (size_t i = 0; i < started; ++i) {
+        void *worker_timings = NULL;
+        pthread_join(threads[i], &worker_timings);
+        if (worker_timings) timings_add(&timings, worker_timings); // workers' time is summed, not wall-clock
+        free(worker_timings);
+    }
 
-    int found = 0;
-    print_interface_header(target_ifname); // print interface header (small function just to format it)
-    for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = (*ifa).ifa_next) {
-        if (!ifa || !(*ifa).ifa_addr) continue; // if no interface or no address on interface, break loop on interface and skip to next one
-        if (strcmp((*ifa).ifa_name, target_ifname) != 0) continue; //if interface name different from target ifname defined before, break and skip like before
-        int family = (*ifa).ifa_addr->sa_family; // Set family from ifa_addr.
-        if (family == AF_INET || family == AF_INET6) {
-            print_address_bullet((*ifa).ifa_addr, (*ifa).ifa_netmask); // If address was found, format it and print it.
-            found = 1; // set flag to 1 to prevent exit, ifname was found
+    int status = EXIT_SUCCESS;
+    size_t shown = 0;
+    struct outbuf *ob = &stdout_buf;
+    if (output_format == FORMAT_JSON) out_puts(ob, "{\"namespaces\":[");
+    for (size_t i = 0; i < sw.count; ++i) {
+        struct netns_entry *e = &sw.entries[i];
+        if (e->err) {
+            fprintf(stderr, "ifshow: netns %s: %s\n", e->name, strerror(e->err));
+            status = EXIT_FAILURE;
+        } else {
+            if (output_format == FORMAT_JSON && shown) out_puts(ob, ",");
+            if (output_format == FORMAT_TEXT) out_printf(ob, "[netns %s]\n", e->name);
+            out_write(ob, e->out.data, e->out.len);
+            shown++;
         }
+        free(e->out.data);
     }
+    if (output_format == FORMAT_JSON) out_puts(ob, "]}\n");
+    free(sw.entries);
+    return status;
+}
 
-    freeifaddrs(ifaddr); // -> Cleanup
-    if (!found) {
-        printf("Interface '%s' not found or has no IP.\n", target_ifname);
+#endif /* __linux__ */
+
+/**
+ * @brief Report --timings on stderr.
+ *
+ * "total" is wall-clock time since main() started; it also covers option
+ * parsing and anything not attributed to a phase. Under --all-netns the
+ * phases are summed over the worker threads.
+ *
+ * @param started_ms  monotonic_ms() at startup.
+ */
+static void print_timings(double started_ms) {
+    fprintf(stderr, "ifshow: timings: enumerate %.3f ms, group %.3f ms, format %.3f ms, output %.3f ms, total %.3f ms\n",
+            timings.enumerate_ms, timings.group_ms, timings.format_ms, timings.output_ms, monotonic_ms() - started_ms);
+    fprintf(stderr, "ifshow: counts: %zu entries, %zu interfaces, %zu addresses, %zu bytes written\n",
+            timings.entries, timings.interfaces, timings.addresses, timings.bytes);
+}
+
+/**
+ * @brief Print a usage error followed by the help text, then exit with failure.
+ *
+ * @param fmt  printf-style message format (followed by its arguments).
+ */
+static void usage_error(const char *fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
+static void usage_error(const char *fmt, ...) {
+    if (output_file.fd >= 0) { // nothing was written yet: report on stdout, keep the old file
+        atomic_file_abort(&output_file);
+        stdout_buf.fd = STDOUT_FILENO;
     }
+    va_list ap;
+    va_start(ap, fmt);
+    out_vprintf(&stdout_buf, fmt, ap);
+    va_end(ap);
+    help();
+    exit(EXIT_FAILURE);
 }
 
 /**
@@ -228,7 +2551,26 @@ static void show_single_interface(const char *target_ifname) {
  *
  * Parses command-line arguments and dispatches to the appropriate action:
  *  - `-a` to list all interfaces
- *  - `-i <name>` to list a specific interface
+ *  - `-i <name>` to list specific interfaces (repeatable, or comma-separated; globs allowed)
+ *  - `-w` to keep following address changes (alone or with `-i`)
+ *  - `--stats` / `--rate <ms>` to print link counters or rates
+ *  - `-l` to print link flags, MTU and hardware address with the addresses
+ *  - `--format=bin` / `--read <file>` to ship snapshots as binary documents and print them back
+ *  - `--summarize` to merge each interface's host addresses into prefixes
+ *  - `--count` / `--exists` to count addresses or test for one, without formatting them
+ *  - `--save <file>` / `--diff <file>` to record a state and report changes since one
+ *  - `--sort=<order>` for deterministic output
+ *  - `-j <n>` to format large snapshots on several threads
+ *  - `--timings` to report where the time went on stderr
+ *  - `--owner <ip>|-` to map addresses to their owning interface
+ *  - `--serve-stdin` to answer queries from stdin off one cached snapshot
+ *  - `--daemon <socket>` / `--via <socket>` to serve `-a` from memory and fetch it
+ *  - `--wait -i <name> [--timeout <ms>]` to block until an interface has an address
+ *  - `--all-netns[=proc]` to list all interfaces of every network namespace
+ *  - `--json` / `--ndjson` / `--format=<name>` to select a machine-readable output format
+ *  - `--output <file>` to replace a file atomically instead of writing to stdout
+ *  - `-4`, `-6`, `--scope`, `--in` to filter addresses before they are formatted
+ *  - `--backend=<name>` to pick how addresses are enumerated
  * On invalid usage, prints help and exits with failure.
  *
  * @param argc  Argument count.
@@ -236,50 +2578,389 @@ static void show_single_interface(const char *target_ifname) {
  * @return `EXIT_SUCCESS` on success; otherwise exits the process with failure.
  */
 int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        { "backend", required_argument, NULL, 'B' },
+        { "json", no_argument, NULL, 'J' },
+        { "ndjson", no_argument, NULL, 'N' },
+        { "all-netns", optional_argument, NULL, 'S' },
+        { "scope", required_argument, NULL, 'C' },
+        { "in", required_argument, NULL, 'R' },
+        { "owner", required_argument, NULL, 'O' },
+        { "stats", no_argument, NULL, 'T' },
+        { "timings", no_argument, NULL, 'M' },
+        { "sort", required_argument, NULL, 'Z' },
+        { "rate", required_argument, NULL, 'E' },
+        { "save", required_argument, NULL, 'V' },
+        { "diff", required_argument, NULL, 'D' },
+        { "format", required_argument, NULL, 'F' },
+        { "output", required_argument, NULL, 'P' },
+        { "count", no_argument, NULL, 'K' },
+        { "exists", no_argument, NULL, 'X' },
+        { "serve-stdin", no_argument, NULL, 'Q' },
+        { "daemon", required_argument, NULL, 'Y' },
+        { "via", required_argument, NULL, 'U' },
+        { "wait", no_argument, NULL, 'W' },
+        { "timeout", required_argument, NULL, 'I' },
+        { "summarize", no_argument, NULL, 'G' },
+        { "read", required_argument, NULL, 'H' },
+        { NULL, 0, NULL, 0 },
+    };
+    int show_all = 0;
+    int watch = 0;
+    int all_netns = 0;  // 1: named namespaces, 2: also /proc/<pid>/ns/net
+    int count_mode = 0; // --count
+    int exists_mode = 0; // --exists
+    int serve = 0;      // --serve-stdin
+    int wait = 0;       // --wait
+    long timeout_ms = -1;           // --timeout for --wait, -1 for none
+    const char **targets = NULL;    // -i names in command-line order, pointing into argv
+    size_t target_count = 0, target_cap = 0;
+    long rate_ms = 0;               // --rate interval, 0 when not sampling
+    const char *save_path = NULL;   // --save state file
+    const char *diff_path = NULL;   // --diff state file
+    const char *output_path = NULL; // --output file, NULL for stdout
+    const char *daemon_path = NULL; // --daemon socket to listen on
+    const char *via_path = NULL;    // --via socket of a daemon to ask
+    const char *read_path = NULL;   // --read bin document to print
+    const char **owners = NULL;     // --owner queries, "-" for stdin
+    size_t owner_count = 0, owner_cap = 0;
 
-    const char *expected_argument_1 = "-a";
-    const char *expected_argument_2 = "-i"; // Has to be one of the two expected arguments, else crash
-
-    if (argc < 2 || argc > 3) {
-        printf("\nUnrecognized number of arguments. Please refer to the following:\n\n");
-        help();
-        exit(EXIT_FAILURE);
+    double started_ms = monotonic_ms();
+    atexit(flush_stdout_at_exit); // error paths exit() with output still buffered
+    if (argc < 2) {
+        usage_error("\nUnrecognized number of arguments. Please refer to the following:\n\n");
     }
 
-    if (strcmp(argv[1], expected_argument_1) == 0) {
-        if (argc != 2) {
-            printf("Error: '-a' must be used alone.\n\n");
-            help();
-            exit(EXIT_FAILURE);
+    opterr = 0; // errors are reported below, with the help text
+    int opt;
+    while ((opt = getopt_long(argc, argv, ":ai:w46j:l", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'a':
+                show_all = 1;
+                break;
+            case 'i': {
+                size_t before = target_count;
+                for (char *name = strtok(optarg, ","); name; name = strtok(NULL, ",")) {
+                    if (target_count == target_cap) {
+                        target_cap = target_cap ? target_cap * 2 : 8;
+                        targets = xrealloc(targets, target_cap * sizeof(*targets));
+                    }
+                    targets[target_count++] = name;
+                }
+                if (target_count == before) usage_error("Error: '-i' requires an interface name.\n\n");
+                break;
+            }
+            case 'w':
+                watch = 1;
+                break;
+            case 'l':
+                show_link = 1;
+                break;
+            case 'G':
+                summarize = 1;
+                break;
+            case 'H':
+                read_path = optarg;
+                break;
+            case '4':
+                addr_filter.families |= FILTER_INET;
+                break;
+            case '6':
+                addr_filter.families |= FILTER_INET6;
+                break;
+            case 'C': {
+                unsigned int scopes = addr_filter_parse_scopes(optarg);
+                if (!scopes) usage_error("Error: '--scope' takes host, link, site or global (comma-separated).\n\n");
+                addr_filter.scopes |= scopes;
+                break;
+            }
+            case 'T':
+                show_stats = 1;
+                break;
+            case 'M':
+                timings_enabled = 1;
+                stdout_buf.sink = timed_write;
+                stdout_buf.sink_arg = &stdout_buf.fd;
+                break;
+            case 'Z':
+                if (strcmp(optarg, "index") == 0) {
+                    sort_order = SORT_INDEX;
+                } else if (strcmp(optarg, "name") == 0) {
+                    sort_order = SORT_NAME;
+                } else if (strcmp(optarg, "addr") == 0) {
+                    sort_order = SORT_ADDR;
+                } else {
+                    usage_error("Unrecognized sort order: '%s'. Please refer to the following:\n\n", optarg);
+                }
+                break;
+            case 'E': {
+                char *end;
+                rate_ms = strtol(optarg, &end, 10);
+                if (*optarg == '\0' || *end || rate_ms <= 0 || rate_ms > 3600000) {
+                    usage_error("Error: '--rate' expects an interval in milliseconds (1..3600000), got '%s'.\n\n", optarg);
+                }
+                break;
+            }
+            case 'j': {
+                char *end;
+                format_jobs = strtol(optarg, &end, 10);
+                if (*optarg == '\0' || *end || format_jobs <= 0 || format_jobs > FORMAT_MAX_JOBS) {
+                    usage_error("Error: '-j' expects a thread count (1..%d), got '%s'.\n\n", FORMAT_MAX_JOBS, optarg);
+                }
+                break;
+            }
+            case 'V':
+                save_path = optarg;
+                break;
+            case 'D':
+                diff_path = optarg;
+                break;
+            case 'O':
+                if (strcmp(optarg, "-") != 0) {
+                    unsigned char probe[16];
+                    if (inet_pton(strchr(optarg, ':') ? AF_INET6 : AF_INET, optarg, probe) != 1) {
+                        usage_error("Error: '--owner' expects an IP address or '-', got '%s'.\n\n", optarg);
+                    }
+                }
+                if (owner_count == owner_cap) {
+                    owner_cap = owner_cap ? owner_cap * 2 : 8;
+                    owners = xrealloc(owners, owner_cap * sizeof(*owners));
+                }
+                owners[owner_count++] = optarg;
+                break;
+            case 'R':
+                if (addr_filter_add_net(&addr_filter, optarg) != 0) usage_error("Error: '--in' expects a network such as 10.0.0.0/8 or fd00::/8 (no host bits past the prefix), got '%s'.\n\n", optarg);
+                break;
+            case 'J':
+                output_format = FORMAT_JSON;
+                break;
+            case 'N':
+                output_format = FORMAT_NDJSON;
+                break;
+            case 'F': {
+                int format = format_parse(optarg);
+                if (format < 0) usage_error("Unrecognized format: '%s'. Please refer to the following:\n\n", optarg);
+                output_format = (enum output_format)format;
+                break;
+            }
+            case 'P':
+                output_path = optarg;
+                break;
+            case 'K':
+                count_mode = 1;
+                break;
+            case 'X':
+                exists_mode = 1;
+                break;
+            case 'Q':
+                serve = 1;
+                break;
+            case 'Y':
+                daemon_path = optarg;
+                break;
+            case 'U':
+                via_path = optarg;
+                break;
+            case 'W':
+                wait = 1;
+                break;
+            case 'I': {
+                char *end;
+                timeout_ms = strtol(optarg, &end, 10);
+                if (*optarg == '\0' || *end || timeout_ms < 0 || timeout_ms > 86400000) {
+                    usage_error("Error: '--timeout' expects a duration in milliseconds (0..86400000), got '%s'.\n\n", optarg);
+                }
+                break;
+            }
+            case 'S':
+                if (!optarg) {
+                    all_netns = 1;
+                } else if (strcmp(optarg, "proc") == 0) {
+                    all_netns = 2;
+                } else {
+                    usage_error("Unrecognized '--all-netns' value: '%s'. Please refer to the following:\n\n", optarg);
+                }
+                break;
+            case 'B':
+                if (strcmp(optarg, "getifaddrs") == 0) {
+                    backend = BACKEND_GETIFADDRS;
+                } else if (strcmp(optarg, "netlink") == 0) {
+#ifdef __linux__
+                    backend = BACKEND_NETLINK;
+#else
+                    usage_error("Error: the netlink backend is only available on Linux.\n\n");
+#endif
+                } else if (strcmp(optarg, "sysctl") == 0) {
+#ifdef HAVE_RT_IFLIST
+                    backend = BACKEND_SYSCTL;
+#else
+                    usage_error("Error: the sysctl backend is only available on BSD and macOS.\n\n");
+#endif
+                } else {
+                    usage_error("Unrecognized backend: '%s'. Please refer to the following:\n\n", optarg);
+                }
+                break;
+            case ':':
+                if (optopt == 'i') usage_error("Error: '-i' requires an interface name.\n\n");
+                usage_error("Error: '%s' requires a value.\n\n", argv[optind - 1]);
+            default:
+                usage_error("Unrecognized argument: '%s'. Please refer to the following:\n\n", argv[optind - 1]);
         }
-        show_all_interfaces();
+    }
+    if (optind < argc) {
+        usage_error("Unrecognized argument: '%s'. Please refer to the following:\n\n", argv[optind]);
     }
 
-    else if (strcmp(argv[1], expected_argument_2) == 0) {
-        if (argc != 3) {
-            printf("Error: '-i' requires an interface name.\n\n");
-            help();
-            exit(EXIT_FAILURE);
+    const char *target_ifname = target_count ? targets[0] : NULL;
+    if (addr_filter.families == (FILTER_INET | FILTER_INET6)) addr_filter.families = 0; // -4 -6: both
+    int status = EXIT_SUCCESS;
+    int link_details = show_stats || show_link; // printed per interface, from one link dump
+    int patterns = 0; // some -i is a glob
+    for (size_t i = 0; i < target_count; ++i) patterns |= name_is_glob(targets[i]);
+    if (patterns && (watch || rate_ms || save_path || diff_path || count_mode || exists_mode || wait)) {
+        usage_error("Error: '-i' patterns select the interfaces to show, use plain names with '-w', '--rate', '--save', '--diff', '--count', '--exists' or '--wait'.\n\n");
+    }
+    if ((show_stats || rate_ms) && backend != BACKEND_NETLINK) {
+        usage_error("Error: '--stats' and '--rate' read link counters over netlink, which this backend does not use.\n\n");
+    }
+    if (rate_ms && (link_details || watch || owner_count || all_netns)) {
+        usage_error("Error: '--rate' cannot be combined with '--stats', '-l', '-w', '--owner' or '--all-netns'.\n\n");
+    }
+    if (timings_enabled && watch) usage_error("Error: '--timings' reports when ifshow exits, which '-w' never does.\n\n");
+    if (link_details && (watch || owner_count)) usage_error("Error: '--stats' and '-l' cannot be combined with '-w' or '--owner'.\n\n");
+    if ((count_mode || exists_mode) && (watch || rate_ms || owner_count || all_netns || save_path || diff_path || link_details)) {
+        usage_error("Error: '--count' and '--exists' cannot be combined with '-w', '--rate', '--owner', '--all-netns', '--save', '--diff', '--stats' or '-l'.\n\n");
+    }
+    if (output_format == FORMAT_OPENMETRICS && (watch || rate_ms || owner_count || all_netns || diff_path)) {
+        usage_error("Error: '--format=openmetrics' describes '-a' or '-i', not '-w', '--rate', '--owner', '--all-netns' or '--diff'.\n\n");
+    }
+    if (format_jobs > 1 && (watch || rate_ms || owner_count || all_netns || save_path || diff_path || count_mode || exists_mode)) {
+        usage_error("Error: '-j' formats the snapshot of '-a' or '-i', not '-w', '--rate', '--owner', '--all-netns', '--save', '--diff', '--count' or '--exists'.\n\n");
+    }
+    if (serve && (show_all || target_ifname || watch || rate_ms || owner_count || all_netns || save_path || diff_path ||
+                  count_mode || exists_mode || link_details || format_jobs > 1 || output_path)) {
+        usage_error("Error: '--serve-stdin' takes its queries from stdin and cannot be combined with another mode, '--stats', '-l', '-j' or '--output'.\n\n");
+    }
+    if (daemon_path && (show_all || target_ifname || watch || rate_ms || owner_count || all_netns || save_path || diff_path ||
+                        count_mode || exists_mode || serve || link_details || format_jobs > 1 || output_path || timings_enabled || via_path)) {
+        usage_error("Error: '--daemon' serves '-a' to '--via' clients and cannot be combined with another mode, '--stats', '-l', '-j', '--output' or '--timings'.\n\n");
+    }
+    if (via_path && (!show_all || watch || rate_ms || owner_count || all_netns || save_path || diff_path ||
+                     count_mode || exists_mode || serve || link_details || format_jobs > 1)) {
+        usage_error("Error: '--via' fetches '-a' from a daemon, use 'ifshow -a --via <socket>' without another mode, '--stats', '-l' or '-j'.\n\n");
+    }
+    if (via_path && (addr_filter_active(&addr_filter) || sort_order != SORT_NONE)) {
+        usage_error("Error: '--via' prints the daemon's snapshot, give '-4', '-6', '--scope', '--in' and '--sort' to '--daemon' instead.\n\n");
+    }
+    if (summarize && (watch || rate_ms || owner_count || save_path || diff_path || count_mode || exists_mode || serve || daemon_path || via_path)) {
+        usage_error("Error: '--summarize' merges the addresses printed by '-a' or '-i', not another mode.\n\n");
+    }
+    if (output_format == FORMAT_BIN && (watch || rate_ms || owner_count || all_netns || diff_path || count_mode || exists_mode || serve || link_details)) {
+        usage_error("Error: '--format=bin' encodes the snapshot of '-a', '-i' or '--read', not another mode, and carries no '--stats' or '-l'.\n\n");
+    }
+    if (read_path && (show_all || target_ifname || watch || rate_ms || owner_count || all_netns || save_path || diff_path ||
+                      count_mode || exists_mode || serve || daemon_path || via_path || wait || link_details)) {
+        usage_error("Error: '--read' prints the document it is given and cannot be combined with '-a', '-i', another mode, '--stats' or '-l'.\n\n");
+    }
+    if (timeout_ms >= 0 && !wait) usage_error("Error: '--timeout' only applies to '--wait'.\n\n");
+    if (wait && (show_all || watch || rate_ms || owner_count || all_netns || save_path || diff_path ||
+                 count_mode || exists_mode || serve || daemon_path || via_path)) {
+        usage_error("Error: '--wait' waits for '-i' interfaces and cannot be combined with another mode.\n\n");
+    }
+    if (output_path && watch) usage_error("Error: '--output' replaces the file when ifshow exits, which '-w' never does.\n\n");
+    if (output_path) {
+        atomic_file_open(&output_file, output_path);
+        stdout_buf.fd = output_file.fd;
+    }
+    if (show_all && target_ifname) {
+        usage_error("Error: '-a' and '-i' cannot be combined.\n\n");
+    } else if (read_path) {
+        status = show_read(read_path);
+    } else if (serve) {
+#ifdef __linux__
+        if (backend != BACKEND_NETLINK) usage_error("Error: '--serve-stdin' requires the netlink backend.\n\n");
+        if (output_format == FORMAT_OPENMETRICS) usage_error("Error: '--serve-stdin' answers per query, use '--json' or '--ndjson' instead of '--format=openmetrics'.\n\n");
+        status = serve_stdin();
+#else
+        usage_error("Error: '--serve-stdin' is only available on Linux.\n\n");
+#endif
+    } else if (daemon_path) {
+#ifdef __linux__
+        if (backend != BACKEND_NETLINK) usage_error("Error: '--daemon' requires the netlink backend.\n\n");
+        status = daemon_serve(daemon_path);
+#else
+        usage_error("Error: '--daemon' is only available on Linux.\n\n");
+#endif
+    } else if (via_path) {
+        status = show_via(via_path);
+    } else if (wait) {
+#ifdef __linux__
+        if (backend != BACKEND_NETLINK) usage_error("Error: '--wait' requires the netlink backend.\n\n");
+        if (!target_ifname) usage_error("Error: '--wait' needs the interfaces to wait for, use '-i <interface_name>'.\n\n");
+        status = wait_for_addresses(targets, target_count, timeout_ms);
+#else
+        usage_error("Error: '--wait' is only available on Linux.\n\n");
+#endif
+    } else if (count_mode || exists_mode) {
+        if (count_mode && exists_mode) usage_error("Error: '--count' and '--exists' cannot be combined.\n\n");
+        if (count_mode && sort_order == SORT_ADDR) usage_error("Error: '--count' has no addresses to sort by, use '--sort=index' or '--sort=name'.\n\n");
+        if (exists_mode && !target_ifname) usage_error("Error: '--exists' needs the interfaces to test, use '-i <interface_name>'.\n\n");
+        status = count_mode ? show_counts(target_count ? targets : NULL, target_count) : show_exists(targets, target_count);
+    } else if (save_path || diff_path) {
+        if (watch || rate_ms || owner_count || all_netns || link_details) {
+            usage_error("Error: '--save' and '--diff' cannot be combined with '-w', '--rate', '--owner', '--all-netns', '--stats' or '-l'.\n\n");
         }
-        show_single_interface(argv[2]);
+        if (diff_path && output_format == FORMAT_JSON) usage_error("Error: '--diff' reports changes, use '--ndjson' instead of '--json'.\n\n");
+        status = show_state(save_path, diff_path, target_count ? targets : NULL, target_count);
+    } else if (rate_ms) {
+        status = show_rates(target_count ? targets : NULL, target_count, rate_ms);
+    } else if (owner_count) {
+        if (show_all || target_ifname || watch || all_netns) usage_error("Error: '--owner' cannot be combined with '-a', '-i', '-w' or '--all-netns'.\n\n");
+        if (output_format == FORMAT_JSON) usage_error("Error: '--owner' answers per query, use '--ndjson' instead of '--json'.\n\n");
+        status = show_owners(owners, owner_count);
+    } else if (all_netns) {
+        if (target_ifname || watch) usage_error("Error: '--all-netns' cannot be combined with '-i' or '-w'.\n\n");
+#ifdef __linux__
+        status = show_all_netns(all_netns == 2);
+#else
+        usage_error("Error: '--all-netns' is only available on Linux.\n\n");
+#endif
+    } else if (watch) {
+#ifdef __linux__
+        if (backend != BACKEND_NETLINK) usage_error("Error: '-w' requires the netlink backend.\n\n");
+        if (output_format == FORMAT_JSON) usage_error("Error: '-w' streams changes, use '--ndjson' instead of '--json'.\n\n");
+        if (target_count > 1) usage_error("Error: '-w' follows a single interface, give only one '-i'.\n\n");
+        watch_addresses(target_ifname);
+#else
+        usage_error("Error: '-w' is only available on Linux.\n\n");
+#endif
+    } else if (show_all) {
+        show_all_interfaces();
+    } else if (target_ifname) {
+        show_interfaces(targets, target_count);
+    } else {
+        usage_error("Error: nothing to show, use '-a' or '-i <interface_name>'.\n\n");
     }
 
-    else {
-        printf("Unrecognized argument: '%s'. Please refer to the following:\n\n", argv[1]);
-        help();
-        exit(EXIT_FAILURE);
+    free(targets);
+    free(owners);
+    free(addr_filter.nets);
+    if (out_flush(&stdout_buf) != 0) {
+        perror(output_path ? output_file.tmp : "write");
+        return EXIT_FAILURE;
     }
-
-    return EXIT_SUCCESS;
+    if (output_path && atomic_file_commit(&output_file) != 0) return EXIT_FAILURE;
+    if (timings_enabled) print_timings(started_ms);
+    return status;
 }
 
-/* Inspired by : 
+/* Inspired by :
 
 - https://gist.github.com/edufelipe/6108057, on error treatment (specifically on getifaddrs) and cleanup ( -> discovered that )
-- https://man.docs.euro-linux.com/EL%207/man-pages-fr/getifaddrs.3.fr.html, https://www.man7.org/linux/man-pages/man3/sockaddr.3type.html 
+- https://man.docs.euro-linux.com/EL%207/man-pages-fr/getifaddrs.3.fr.html, https://www.man7.org/linux/man-pages/man3/sockaddr.3type.html
   and other diver man docs for already built struct and functions linked to defined libs.
 - Designed initial logic, backend logic, functions logic, comments.
 
 - AI made / inspired : help() function, print_address_bullet() (initially designed by hand and refactored with AI), addr_to_string() (linked to previously AI reworked function), github workflow to release binary on github and IPv6 netmask coputing.
   AI was mainly used to reduce code complexity, better User eXperience and better User Treeatment.
-*/
\ No newline at end of file
+*/
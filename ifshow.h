@@ -0,0 +1,274 @@
+/*
+ * ifshow.h - Embeddable interface/address snapshots (libifshow).
+ * FR: ifshow.h - Instantanés d'interfaces et d'adresses intégrables (libifshow).
+ *
+ * Build / Compilation (from the repository root):
+ *   gcc -Wall -Wextra -O2 -c libifshow.c && ar rcs libifshow.a libifshow.o
+ *
+ * Usage / Utilisation:
+ * - ifshow_open(). EN: One context per thread; it keeps its netlink socket across snapshots.
+ *   FR: Un contexte par thread ; il garde sa socket netlink d'un instantané à l'autre.
+ * - ifshow_snapshot_take(). EN: Enumerate once, then query, iterate or format without syscalls.
+ *   FR: Énumère une fois, puis interroge, parcourt ou formate sans appel système.
+ * - ifshow_snapshot_free(). EN: Release everything the snapshot holds. FR: Libère tout l'instantané.
+ *
+ * Functions returning `int` give 0 (or a documented count) on success and
+ * -1 with errno set on failure; functions returning pointers give NULL with
+ * errno set. Only allocation failure terminates the process. Contexts and
+ * snapshots are not thread-safe: use one per thread, or serialize the calls.
+ * Every type below keeps its layout for a given IFSHOW_API_VERSION.
+ */
+
+#ifndef IFSHOW_H
+#define IFSHOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IFSHOW_API_VERSION 1
+
+/**
+ * @brief Enumeration backends.
+ */
+enum ifshow_backend {
+    IFSHOW_BACKEND_DEFAULT,     // netlink on Linux, sysctl on BSD/macOS, getifaddrs elsewhere
+    IFSHOW_BACKEND_GETIFADDRS,  // portable libc getifaddrs()
+    IFSHOW_BACKEND_NETLINK,     // Linux rtnetlink RTM_GETADDR dump
+    IFSHOW_BACKEND_SYSCTL,      // BSD/macOS sysctl(NET_RT_IFLIST) routing messages
+};
+
+/**
+ * @brief Address scopes, from widest to narrowest.
+ */
+enum ifshow_scope {
+    IFSHOW_SCOPE_GLOBAL,
+    IFSHOW_SCOPE_SITE,
+    IFSHOW_SCOPE_LINK,
+    IFSHOW_SCOPE_HOST,
+};
+
+/**
+ * @brief Orders a snapshot can be taken in (same as the CLI's --sort).
+ */
+enum ifshow_sort {
+    IFSHOW_SORT_NONE,   // backend order, interfaces first-seen
+    IFSHOW_SORT_INDEX,  // by ifindex (aliases by name), then address
+    IFSHOW_SORT_NAME,   // by interface name, then address
+    IFSHOW_SORT_ADDR,   // by address; interfaces follow their lowest address
+};
+
+/**
+ * @brief Output formats of ifshow_snapshot_format() (same bytes as the CLI).
+ */
+enum ifshow_format {
+    IFSHOW_FORMAT_TEXT,     // grouped, human-readable bullets
+    IFSHOW_FORMAT_JSON,     // one JSON document
+    IFSHOW_FORMAT_NDJSON,   // one JSON record per address
+    IFSHOW_FORMAT_OPENMETRICS, // Prometheus/OpenMetrics text, ends with "# EOF"
+    IFSHOW_FORMAT_BIN,      // little-endian binary document, see ifshow_snapshot_decode()
+};
+
+#define IFSHOW_STATS 0x1u // ifshow_request.flags: also read the link counters (netlink only)
+#define IFSHOW_LINK 0x2u  // ifshow_request.flags: also read flags, MTU and hardware address of every link
+#define IFSHOW_SUMMARIZE 0x4u // ifshow_request.flags: merge each interface's host addresses into prefixes
+
+/**
+ * @brief One address of a snapshot.
+ */
+struct ifshow_addr {
+    const char *ifname;         // interface name (IPv4 label when one is set), owned by the snapshot
+    unsigned int ifindex;       // kernel interface index, 0 if the backend does not know it
+    int family;                 // AF_INET or AF_INET6
+    int prefix;                 // prefix length, -1 without netmask, -2 for a non-contiguous one
+    int scope;                  // enum ifshow_scope
+    unsigned char addr[16];     // address bytes in network order (first 4 used for IPv4)
+};
+
+/**
+ * @brief Counters of one link (IFLA_STATS64).
+ */
+struct ifshow_link_stats {
+    uint64_t rx_bytes, rx_packets, rx_errors, rx_dropped;
+    uint64_t tx_bytes, tx_packets, tx_errors, tx_dropped;
+};
+
+/**
+ * @brief Link-layer state of one link (IFSHOW_LINK).
+ */
+struct ifshow_link {
+    unsigned int flags;         // IFF_* (IFF_LOWER_UP included on Linux)
+    unsigned int mtu;           // 0 if unknown
+    unsigned char hwaddr[32];   // hardware address, `hwlen` bytes
+    size_t hwlen;               // 0 for links without one
+};
+
+struct ifshow_ctx;
+struct ifshow_filter;
+struct ifshow_snapshot;
+
+/**
+ * @brief What ifshow_snapshot_take() collects; zero-initialize for "everything, backend order".
+ */
+struct ifshow_request {
+    const char *const *names;           // only these interfaces, in this order (names without addresses are kept), or NULL
+    size_t name_count;
+    const struct ifshow_filter *filter; // address filter, or NULL for none
+    enum ifshow_sort sort;
+    unsigned int flags;                 // IFSHOW_STATS, IFSHOW_LINK, IFSHOW_SUMMARIZE
+};
+
+/**
+ * @brief Visitor called once per address; a non-zero return stops the iteration.
+ */
+typedef int (*ifshow_addr_fn)(const struct ifshow_addr *addr, void *arg);
+
+/**
+ * @brief Output sink of ifshow_snapshot_format(); a non-zero return aborts the formatting.
+ */
+typedef int (*ifshow_write_fn)(const void *data, size_t len, void *arg);
+
+/**
+ * @brief Create a context for one backend.
+ *
+ * @param backend  Backend to enumerate with.
+ * @return Context, or NULL (ENOTSUP for netlink off Linux or sysctl off BSD/macOS, EINVAL for an unknown backend).
+ */
+struct ifshow_ctx *ifshow_open(enum ifshow_backend backend);
+
+/**
+ * @brief Close a context and its socket. Snapshots taken from it stay valid.
+ *
+ * @param ctx  Context, or NULL.
+ */
+void ifshow_close(struct ifshow_ctx *ctx);
+
+/**
+ * @brief Create an empty filter (accepts every address).
+ */
+struct ifshow_filter *ifshow_filter_new(void);
+
+/**
+ * @brief Accept this family (AF_INET or AF_INET6); no call accepts both.
+ *
+ * @return 0, or -1 (EINVAL) for another family.
+ */
+int ifshow_filter_family(struct ifshow_filter *f, int family);
+
+/**
+ * @brief Accept these scopes: a comma-separated list of host, link, site and global.
+ *
+ * @return 0, or -1 (EINVAL) for an unknown scope.
+ */
+int ifshow_filter_scopes(struct ifshow_filter *f, const char *scopes);
+
+/**
+ * @brief Accept addresses inside this network ("10.0.0.0/8", "fd00::/8"); may be called repeatedly.
+ *
+ * @return 0, or -1 (EINVAL) if `cidr` is not a network, host bits past the prefix included.
+ */
+int ifshow_filter_network(struct ifshow_filter *f, const char *cidr);
+
+/**
+ * @brief Release a filter (snapshots taken with it are not affected).
+ *
+ * @param f  Filter, or NULL.
+ */
+void ifshow_filter_free(struct ifshow_filter *f);
+
+/**
+ * @brief Enumerate the addresses (and with IFSHOW_STATS / IFSHOW_LINK, the links) once.
+ *
+ * @param ctx  Context; its socket is reused.
+ * @param req  What to collect, or NULL for every address in backend order.
+ * @return Snapshot, or NULL on enumeration failure.
+ */
+struct ifshow_snapshot *ifshow_snapshot_take(struct ifshow_ctx *ctx, const struct ifshow_request *req);
+
+/**
+ * @brief Rebuild a snapshot from an IFSHOW_FORMAT_BIN document (e.g. a mapped file).
+ *
+ * The document is copied; `data` may be released afterwards. Interfaces keep
+ * the document's order, formatting reproduces it, and the snapshot has no link data.
+ *
+ * @param data  Document bytes.
+ * @param len   Size of the document.
+ * @return Snapshot, or NULL (EINVAL) if `data` is not exactly one well-formed document.
+ */
+struct ifshow_snapshot *ifshow_snapshot_decode(const void *data, size_t len);
+
+/**
+ * @brief Number of interfaces (grouped by name) in a snapshot.
+ */
+size_t ifshow_snapshot_interface_count(const struct ifshow_snapshot *s);
+
+/**
+ * @brief Name of interface `i` (0 <= i < ifshow_snapshot_interface_count()), or NULL past the end.
+ */
+const char *ifshow_snapshot_interface(const struct ifshow_snapshot *s, size_t i);
+
+/**
+ * @brief Visit addresses interface by interface.
+ *
+ * @param s       Snapshot.
+ * @param ifname  Only this interface, or NULL for all.
+ * @param fn      Visitor.
+ * @param arg     Opaque pointer handed to the visitor.
+ * @return Number of addresses visited.
+ */
+size_t ifshow_snapshot_foreach(const struct ifshow_snapshot *s, const char *ifname, ifshow_addr_fn fn, void *arg);
+
+/**
+ * @brief Link counters of a device taken with IFSHOW_STATS.
+ *
+ * @return 0, or -1 (ENOENT) if the snapshot has no counters for `ifname`.
+ */
+int ifshow_snapshot_stats(const struct ifshow_snapshot *s, const char *ifname, struct ifshow_link_stats *stats);
+
+/**
+ * @brief Link-layer state of a device taken with IFSHOW_LINK.
+ *
+ * @return 0, or -1 (ENOENT) if the snapshot has no link-layer state for `ifname`.
+ */
+int ifshow_snapshot_link(const struct ifshow_snapshot *s, const char *ifname, struct ifshow_link *link);
+
+/**
+ * @brief Interface owning an address: the local address itself, else the longest matching prefix.
+ *
+ * The longest-prefix index is built on the first call.
+ *
+ * @param s        Snapshot.
+ * @param address  IPv4 or IPv6 address text.
+ * @param owner    Receives the owning address (valid until the snapshot is freed).
+ * @return 1 if found, 0 if no prefix contains it, -1 (EINVAL) if `address` is not an address.
+ */
+int ifshow_snapshot_owner(struct ifshow_snapshot *s, const char *address, struct ifshow_addr *owner);
+
+/**
+ * @brief Format a snapshot exactly like `ifshow -a` (or `-i` with names) would.
+ *
+ * Output is handed to `write` in chunks of up to a few hundred KiB.
+ *
+ * @param s       Snapshot.
+ * @param format  Output format.
+ * @param write   Sink.
+ * @param arg     Opaque pointer handed to the sink.
+ * @return 0, or -1 if the sink failed (errno as left by it) or `format` is unknown (EINVAL).
+ */
+int ifshow_snapshot_format(struct ifshow_snapshot *s, enum ifshow_format format, ifshow_write_fn write, void *arg);
+
+/**
+ * @brief Release a snapshot.
+ *
+ * @param s  Snapshot, or NULL.
+ */
+void ifshow_snapshot_free(struct ifshow_snapshot *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IFSHOW_H */
@@ -0,0 +1,3184 @@
+/*
+ * libifshow - Interface/address enumeration, snapshots and formatting behind ifshow.
+ * FR: libifshow - Énumération des interfaces/adresses, instantanés et formatage derrière ifshow.
+ *
+ * Build / Compilation (from the repository root):
+ *   gcc -Wall -Wextra -O2 -c libifshow.c && ar rcs libifshow.a libifshow.o
+ *
+ * Usage / Utilisation:
+ * - #include "ifshow.h". EN: Public API (ifshow_*), see the header. FR: API publique (ifshow_*), voir l'en-tête.
+ * - #include "libifshow_internal.h". EN: Internals shared with the CLI and tests/ (linked from libifshow.a).
+ *   FR: Fonctions internes partagées avec la CLI et tests/ (liées depuis libifshow.a).
+ *
+ * Besides the ifshow_* functions, only what libifshow_internal.h declares is
+ * extern; the release archive keeps just ifshow_* global. None of it reads
+ * the command line: backends, filters, orders and formats are parameters.
+ */
+
+#include "libifshow_internal.h"
+
+#include <ctype.h>
+#include <ifaddrs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+
+// "00".."99": two decimal digits per entry, so numbers below 1000 need at most one division pair.
+static const char digit_pairs[200] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Write a number below 1000 in decimal, without leading zeros.
+ *
+ * @param dst  Destination, at least 3 bytes; not NUL-terminated.
+ * @param v    Value, 0..999.
+ * @return Number of characters written (1..3).
+ */
+static size_t fmt_small_uint(char *dst, unsigned int v) {
+    if (v >= 100) {
+        dst[0] = (char)('0' + v / 100);
+        memcpy(dst + 1, digit_pairs + 2 * (v % 100), 2);
+        return 3;
+    }
+    if (v >= 10) {
+        memcpy(dst, digit_pairs + 2 * v, 2);
+        return 2;
+    }
+    dst[0] = (char)('0' + v);
+    return 1;
+}
+
+/**
+ * @brief Write an IPv4 address in dotted-decimal form.
+ *
+ * @param dst  Destination, at least 15 bytes; not NUL-terminated.
+ * @param a    Address bytes in network order.
+ * @return Number of characters written.
+ */
+size_t fmt_ipv4(char *dst, const unsigned char *a) {
+    size_t n = fmt_small_uint(dst, a[0]);
+    for (int i = 1; i < 4; ++i) {
+        dst[n++] = '.';
+        n += fmt_small_uint(dst + n, a[i]);
+    }
+    return n;
+}
+
+/**
+ * @brief Write an IPv6 address the way glibc `inet_ntop` does (RFC 5952).
+ *
+ * Lowercase hex without leading zeros, the first longest run of two or more
+ * zero groups compressed to "::", and IPv4-mapped / IPv4-compatible
+ * addresses ending in dotted decimal.
+ *
+ * @param dst  Destination, at least 45 bytes; not NUL-terminated.
+ * @param a    Address bytes in network order.
+ * @return Number of characters written.
+ */
+size_t fmt_ipv6(char *dst, const unsigned char *a) {
+    static const char hex[] = "0123456789abcdef";
+    unsigned int words[8];
+    int best_base = -1, best_len = 0, cur_base = -1, cur_len = 0;
+    for (int i = 0; i < 8; ++i) {
+        words[i] = (unsigned int)a[2 * i] << 8 | a[2 * i + 1];
+        if (words[i] == 0) {
+            if (cur_base < 0) cur_base = i, cur_len = 0;
+            if (++cur_len > best_len) best_base = cur_base, best_len = cur_len;
+        } else {
+            cur_base = -1;
+        }
+    }
+    if (best_len < 2) best_base = -1; // a single zero group is not compressed
+
+    size_t n = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (best_base >= 0 && i >= best_base && i < best_base + best_len) {
+            if (i == best_base) dst[n++] = ':';
+            continue;
+        }
+        if (i != 0) dst[n++] = ':';
+        if (i == 6 && best_base == 0 && (best_len == 6 || (best_len == 5 && words[5] == 0xffff))) {
+            return n + fmt_ipv4(dst + n, a + 12); // ::a.b.c.d and ::ffff:a.b.c.d
+        }
+        unsigned int w = words[i];
+        if (w >= 0x1000) dst[n++] = hex[w >> 12];
+        if (w >= 0x100) dst[n++] = hex[(w >> 8) & 15];
+        if (w >= 0x10) dst[n++] = hex[(w >> 4) & 15];
+        dst[n++] = hex[w & 15];
+    }
+    if (best_base >= 0 && best_base + best_len == 8) dst[n++] = ':';
+    return n;
+}
+
+/**
+ * @brief Convert a raw address to a numeric host string.
+ *
+ * Converts IPv4 or IPv6 address bytes to their numeric string representation
+ * with the specialized formatters above (byte-identical to `inet_ntop`, no DNS
+ * lookups involved).
+ *
+ * @param family  AF_INET or AF_INET6.
+ * @param addr    Address bytes in network order. Must not be NULL.
+ * @param buf     Output buffer to receive the NUL-terminated host string.
+ * @param buflen  Size (in bytes) of the output buffer; INET6_ADDRSTRLEN always suffices.
+ * @return String length on success; -1 on failure (NULL args, unsupported family, or buffer too small).
+ */
+int addr_to_string(int family, const void *addr, char *buf, size_t buflen) {
+    if (!addr || !buf || buflen == 0) return -1;
+    char tmp[INET6_ADDRSTRLEN];
+    char *dst = buflen >= sizeof(tmp) ? buf : tmp; // format in place when the result surely fits
+    size_t n;
+    if (family == AF_INET) {
+        n = fmt_ipv4(dst, addr);
+    } else if (family == AF_INET6) {
+        n = fmt_ipv6(dst, addr);
+    } else {
+        return -1;
+    }
+    if (n >= buflen) return -1;
+    if (dst != buf) memcpy(buf, dst, n);
+    buf[n] = '\0';
+    return (int)n;
+}
+
+#if defined(__GNUC__)
+#define clz32(x) __builtin_clz(x)
+#define clz64(x) __builtin_clzll(x)
+#else
+/** @brief Count leading zero bits of a non-zero 32-bit word (portable fallback). */
+static int clz32(uint32_t x) {
+    int n = 0;
+    if (!(x & 0xffff0000u)) n += 16, x <<= 16;
+    if (!(x & 0xff000000u)) n += 8, x <<= 8;
+    if (!(x & 0xf0000000u)) n += 4, x <<= 4;
+    if (!(x & 0xc0000000u)) n += 2, x <<= 2;
+    if (!(x & 0x80000000u)) n += 1;
+    return n;
+}
+/** @brief Count leading zero bits of a non-zero 64-bit word (portable fallback). */
+static int clz64(uint64_t x) {
+    return (x >> 32) ? clz32((uint32_t)(x >> 32)) : 32 + clz32((uint32_t)x);
+}
+#endif
+
+/**
+ * @brief Prefix length of a 32-bit mask word (host order).
+ *
+ * @param m  Mask word.
+ * @return Number of leading 1-bits (0..32), or PREFIX_NONCONTIGUOUS if any 1-bit follows the first 0.
+ */
+static int mask_prefix32(uint32_t m) {
+    if (m == 0xffffffffu) return 32;
+    int ones = clz32(~m);
+    return (uint32_t)(m << ones) == 0 ? ones : PREFIX_NONCONTIGUOUS; // nothing may remain after the run
+}
+
+/**
+ * @brief Prefix length of a 64-bit mask word (host order).
+ *
+ * @param m  Mask word.
+ * @return Number of leading 1-bits (0..64), or PREFIX_NONCONTIGUOUS if any 1-bit follows the first 0.
+ */
+static int mask_prefix64(uint64_t m) {
+    if (m == ~(uint64_t)0) return 64;
+    int ones = clz64(~m);
+    return (uint64_t)(m << ones) == 0 ? ones : PREFIX_NONCONTIGUOUS;
+}
+
+/**
+ * @brief Load 8 big-endian bytes as a 64-bit word.
+ */
+static uint64_t load_be64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = v << 8 | p[i];
+    return v;
+}
+
+/**
+ * @brief Compute CIDR prefix length from a netmask sockaddr.
+ *
+ * Supports IPv4 and IPv6 netmasks. Counts the leading 1-bits with one
+ * count-leading-zeros per 32-bit (IPv4) or 64-bit (IPv6) word, and checks
+ * that no 1-bit follows, so a non-contiguous mask is reported instead of
+ * being truncated to its leading run.
+ *
+ * @param netmask  Pointer to a netmask `sockaddr` (AF_INET or AF_INET6).
+ * @return Prefix length (0..32 for IPv4, 0..128 for IPv6); PREFIX_NONCONTIGUOUS
+ *         for a non-contiguous mask; -1 if `netmask` is NULL or the address
+ *         family is unsupported.
+ */
+int count_prefix_length(const struct sockaddr *netmask) {
+    if (!netmask) return -1; // error on netmask undefined
+    if (netmask->sa_family == AF_INET) { // if v4
+        const struct sockaddr_in *nm4 = (const struct sockaddr_in *)netmask;
+        return mask_prefix32(ntohl(nm4->sin_addr.s_addr)); // network to host byte order
+    } else if (netmask->sa_family == AF_INET6) { //else v6
+        const unsigned char *b = ((const struct sockaddr_in6 *)netmask)->sin6_addr.s6_addr;
+        int hi = mask_prefix64(load_be64(b));
+        uint64_t lo = load_be64(b + 8);
+        if (hi < 64) return (hi < 0 || lo == 0) ? hi : PREFIX_NONCONTIGUOUS; // low word must be empty
+        int lo_prefix = mask_prefix64(lo);
+        return lo_prefix < 0 ? lo_prefix : 64 + lo_prefix;
+    }
+    return -1;
+}
+
+// (previous single-line formatter removed in favor of grouped bullet output)
+
+/**
+ * @brief Allocate or resize a heap block, exiting the process on failure.
+ *
+ * @param ptr   Block to resize, or NULL to allocate a new one.
+ * @param size  Requested size in bytes.
+ * @return Pointer to the (possibly moved) block; never NULL.
+ */
+void *xrealloc(void *ptr, size_t size) {
+    void *p = realloc(ptr, size ? size : 1);
+    if (!p) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+#define OUT_FLUSH_THRESHOLD (256 * 1024) // pending bytes that trigger a write on file-backed buffers
+
+/**
+ * @brief Write all pending bytes to the buffer's descriptor or sink.
+ *
+ * @param ob  Buffer to flush; emptied on success. No-op for memory-only buffers.
+ * @return 0 on success; -1 on write failure (errno set, pending bytes dropped),
+ *         and for a sink, on every flush after it failed once.
+ */
+int out_flush(struct outbuf *ob) {
+    if (ob->sink) {
+        if (!ob->failed && ob->len && ob->sink(ob->data, ob->len, ob->sink_arg) != 0) ob->failed = 1;
+        ob->len = 0;
+        return ob->failed ? -1 : 0;
+    }
+    if (ob->fd < 0) return 0;
+    size_t off = 0;
+    int rc = 0;
+    while (off < ob->len) {
+        ssize_t n = write(ob->fd, ob->data + off, ob->len - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        off += (size_t)n;
+    }
+    ob->len = 0;
+    return rc;
+}
+
+/**
+ * @brief Make room for `n` more bytes at the end of the buffer.
+ *
+ * Flushes first when a file-backed buffer would pass the threshold. The
+ * caller writes into the returned space and then advances `ob->len`.
+ *
+ * @param ob  Buffer to grow.
+ * @param n   Number of bytes needed.
+ * @return Pointer to at least `n` writable bytes.
+ */
+char *out_reserve(struct outbuf *ob, size_t n) {
+    if ((ob->fd >= 0 || ob->sink) && ob->len + n > OUT_FLUSH_THRESHOLD && ob->len > 0) {
+        if (out_flush(ob) != 0 && !ob->sink) perror("write"); // sink failures surface on the final flush
+    }
+    if (ob->len + n > ob->cap) {
+        size_t cap = ob->cap ? ob->cap : 4096;
+        while (cap < ob->len + n) cap *= 2;
+        ob->data = xrealloc(ob->data, cap);
+        ob->cap = cap;
+    }
+    return ob->data + ob->len;
+}
+
+/**
+ * @brief Append raw bytes to the buffer.
+ *
+ * @param ob    Buffer to append to.
+ * @param data  Bytes to copy.
+ * @param n     Number of bytes.
+ */
+void out_write(struct outbuf *ob, const void *data, size_t n) {
+    memcpy(out_reserve(ob, n), data, n);
+    ob->len += n;
+}
+
+/**
+ * @brief Append a NUL-terminated string to the buffer.
+ *
+ * @param ob  Buffer to append to.
+ * @param s   String to copy (without its terminator).
+ */
+void out_puts(struct outbuf *ob, const char *s) {
+    out_write(ob, s, strlen(s));
+}
+
+/**
+ * @brief Append printf-style formatted text to the buffer.
+ *
+ * @param ob   Buffer to append to.
+ * @param fmt  printf-style format.
+ * @param ap   Format arguments.
+ */
+void out_vprintf(struct outbuf *ob, const char *fmt, va_list ap) {
+    va_list again;
+    va_copy(again, ap);
+    size_t room = ob->cap - ob->len;
+    int n = vsnprintf(room ? ob->data + ob->len : NULL, room, fmt, ap);
+    if (n >= 0 && (size_t)n >= room) { // did not fit: grow to the exact size and format again
+        vsnprintf(out_reserve(ob, (size_t)n + 1), (size_t)n + 1, fmt, again);
+    }
+    va_end(again);
+    if (n > 0) ob->len += (size_t)n;
+}
+
+/**
+ * @brief Append printf-style formatted text to the buffer.
+ *
+ * @param ob   Buffer to append to.
+ * @param fmt  printf-style format (followed by its arguments).
+ */
+void out_printf(struct outbuf *ob, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    out_vprintf(ob, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief Scope of an address, derived from its bits.
+ *
+ * Used by the getifaddrs backend, which has no kernel scope to report; it
+ * matches what the kernel assigns by default.
+ *
+ * @param family  AF_INET or AF_INET6.
+ * @param addr    Address bytes in network order.
+ * @return enum addr_scope value.
+ */
+int addr_scope_of(int family, const unsigned char *addr) {
+    if (family == AF_INET) {
+        if (addr[0] == 127) return SCOPE_HOST;
+        if (addr[0] == 169 && addr[1] == 254) return SCOPE_LINK;
+        return SCOPE_GLOBAL;
+    }
+    static const unsigned char loopback[16] = { [15] = 1 };
+    if (memcmp(addr, loopback, 16) == 0) return SCOPE_HOST;
+    if (addr[0] == 0xfe && (addr[1] & 0xc0) == 0x80) return SCOPE_LINK;
+    if (addr[0] == 0xfe && (addr[1] & 0xc0) == 0xc0) return SCOPE_SITE;
+    return SCOPE_GLOBAL;
+}
+
+/**
+ * @brief Whether any filter criterion was given.
+ */
+int addr_filter_active(const struct addr_filter *f) {
+    return f->families || f->scopes || f->net_count;
+}
+
+/**
+ * @brief Test an address against a compiled filter.
+ *
+ * @param f   Compiled filter.
+ * @param ai  Address to test.
+ * @return Non-zero if the address is kept.
+ */
+int addr_filter_match(const struct addr_filter *f, const struct addr_info *ai) {
+    if (f->families && !(f->families & (ai->family == AF_INET ? FILTER_INET : FILTER_INET6))) return 0;
+    if (f->scopes && !(f->scopes & (1u << ai->scope))) return 0;
+    if (!f->net_count) return 1;
+    uint32_t words[4];
+    memcpy(words, ai->addr, sizeof(words));
+    size_t n = ai->family == AF_INET ? 1 : 4;
+    for (size_t i = 0; i < f->net_count; ++i) {
+        const struct filter_net *net = &f->nets[i];
+        if (net->family != ai->family) continue;
+        size_t w = 0;
+        while (w < n && (words[w] & net->mask[w]) == net->net[w]) ++w;
+        if (w == n) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parse a `--scope` list ("host,link,...") into scope bits.
+ *
+ * @param list  Comma-separated scope names (empty items are skipped).
+ * @return Scope bits, or 0 if a name is unknown or the list is empty.
+ */
+unsigned int addr_filter_parse_scopes(const char *list) {
+    static const char *const names[] = { [SCOPE_GLOBAL] = "global", [SCOPE_SITE] = "site", [SCOPE_LINK] = "link", [SCOPE_HOST] = "host" };
+    unsigned int bits = 0;
+    for (const char *name = list; *name; name += *name == ',') {
+        size_t len = strcspn(name, ","), i = 0;
+        if (len == 0) continue;
+        while (i < sizeof(names) / sizeof(names[0]) && (strlen(names[i]) != len || strncmp(name, names[i], len) != 0)) ++i;
+        if (i == sizeof(names) / sizeof(names[0])) return 0;
+        bits |= 1u << i;
+        name += len;
+    }
+    return bits;
+}
+
+/**
+ * @brief Parse `<address>[/<prefix>]` and add it as an `--in` network.
+ *
+ * The prefix is decimal digits only ("/8", not "/+8" or "/ 8"), and no host
+ * bit may be set past it: "10.1.2.3/8" is rejected rather than read as
+ * 10.0.0.0/8. Without a prefix the network is the single address.
+ *
+ * @param f     Filter to extend.
+ * @param cidr  Network text.
+ * @return 0 on success; -1 if the text is not a valid IPv4/IPv6 network.
+ */
+int addr_filter_add_net(struct addr_filter *f, const char *cidr) {
+    char text[INET6_ADDRSTRLEN];
+    const char *slash = strchr(cidr, '/');
+    size_t len = slash ? (size_t)(slash - cidr) : strlen(cidr);
+    if (len == 0 || len >= sizeof(text)) return -1;
+    memcpy(text, cidr, len);
+    text[len] = '\0';
+
+    struct filter_net net = { .family = strchr(text, ':') ? AF_INET6 : AF_INET };
+    unsigned char addr[16] = {0}, mask[16] = {0};
+    if (inet_pton(net.family, text, addr) != 1) return -1;
+    int bits = net.family == AF_INET ? 32 : 128;
+    int prefix = bits;
+    if (slash) {
+        const char *p = slash + 1;
+        if (!isdigit((unsigned char)*p)) return -1;
+        for (prefix = 0; isdigit((unsigned char)*p) && prefix <= bits; ++p) prefix = prefix * 10 + (*p - '0');
+        if (*p || prefix > bits) return -1;
+    }
+    for (int i = 0; i < prefix; ++i) mask[i / 8] |= (unsigned char)(0x80 >> (i % 8));
+    for (int i = 0; i < 16; ++i) {
+        if (addr[i] & ~mask[i]) return -1; // host bits set: a typo for another network, or an address
+    }
+    memcpy(net.net, addr, sizeof(net.net));
+    memcpy(net.mask, mask, sizeof(net.mask));
+
+    if (f->net_count == f->net_cap) {
+        f->net_cap = f->net_cap ? f->net_cap * 2 : 4;
+        f->nets = xrealloc(f->nets, f->net_cap * sizeof(*f->nets));
+    }
+    f->nets[f->net_count++] = net;
+    return 0;
+}
+
+/**
+ * @brief Whether an interface name (an -i argument) is a pattern rather than a plain name.
+ */
+int name_is_glob(const char *name) {
+    return strpbrk(name, "*?[") != NULL;
+}
+
+/**
+ * @brief Parse a bracket class starting at `p` (just after '[').
+ *
+ * @param p    Pattern text after the '['.
+ * @param set  Receives the accepted bytes.
+ * @return Pointer just past the closing ']', or NULL if the class is not terminated.
+ */
+static const char *glob_parse_class(const char *p, unsigned char set[32]) {
+    int negate = *p == '!' || *p == '^';
+    if (negate) p++;
+    memset(set, 0, 32);
+    for (int first = 1; *p && (first || *p != ']'); first = 0) {
+        unsigned char lo = (unsigned char)*p++, hi = lo;
+        if (lo == '\\' && *p) lo = hi = (unsigned char)*p++;
+        if (*p == '-' && p[1] && p[1] != ']') {
+            hi = (unsigned char)p[1];
+            p += 2;
+            if (hi == '\\' && *p) hi = (unsigned char)*p++;
+        }
+        for (unsigned int c = lo; c <= hi; ++c) set[c / 8] |= (unsigned char)(1u << (c % 8));
+    }
+    if (*p != ']') return NULL;
+    if (negate) {
+        for (int i = 0; i < 32; ++i) set[i] = (unsigned char)~set[i];
+    }
+    set[0] &= (unsigned char)~1u; // never the terminating NUL
+    return p + 1;
+}
+
+/**
+ * @brief Compile a pattern; an unterminated '[' matches itself.
+ *
+ * @param g     Glob to fill (zeroed); release with name_glob_free().
+ * @param text  Pattern, kept by reference.
+ */
+void name_glob_compile(struct name_glob *g, const char *text) {
+    size_t len = strlen(text);
+    memset(g, 0, sizeof(*g));
+    g->text = text;
+    g->prefix = xrealloc(NULL, len + 1);
+    g->tokens = xrealloc(NULL, (len ? len : 1) * sizeof(*g->tokens));
+    int literal_run = 1; // still in the leading literal prefix
+    for (const char *p = text; *p;) {
+        struct glob_token t = {0};
+        unsigned char c = (unsigned char)*p++;
+        if (c == '*') {
+            while (*p == '*') p++;
+            t.star = 1;
+        } else if (c == '?') {
+            memset(t.set, 0xff, sizeof(t.set));
+            t.set[0] &= (unsigned char)~1u;
+        } else {
+            const char *end = c == '[' ? glob_parse_class(p, t.set) : NULL;
+            if (end) {
+                p = end;
+            } else {
+                if (c == '\\' && *p) c = (unsigned char)*p++;
+                if (literal_run) {
+                    g->prefix[g->prefix_len++] = (char)c;
+                    continue;
+                }
+                t.set[c / 8] |= (unsigned char)(1u << (c % 8));
+            }
+        }
+        literal_run = 0;
+        g->tokens[g->token_count++] = t;
+    }
+    g->prefix[g->prefix_len] = '\0';
+}
+
+/**
+ * @brief Match a name against a compiled glob.
+ *
+ * Prefix first, then the tokens with the usual last-star backtracking:
+ * linear in the name for patterns with at most one '*'.
+ *
+ * @param g     Compiled glob.
+ * @param name  Interface name.
+ * @return Non-zero if the whole name matches.
+ */
+int name_glob_match(const struct name_glob *g, const char *name) {
+    if (strncmp(name, g->prefix, g->prefix_len) != 0) return 0;
+    const unsigned char *s = (const unsigned char *)name + g->prefix_len, *star_s = NULL;
+    size_t t = 0, star_t = 0;
+    int starred = 0;
+    while (*s) {
+        if (t < g->token_count && g->tokens[t].star) {
+            starred = 1;
+            star_t = ++t;
+            star_s = s;
+        } else if (t < g->token_count && (g->tokens[t].set[*s / 8] & (1u << (*s % 8)))) {
+            t++;
+            s++;
+        } else if (starred) {
+            t = star_t; // let the last '*' swallow one more character
+            s = ++star_s;
+        } else {
+            return 0;
+        }
+    }
+    while (t < g->token_count && g->tokens[t].star) t++;
+    return t == g->token_count;
+}
+
+/**
+ * @brief Release a compiled glob.
+ */
+void name_glob_free(struct name_glob *g) {
+    free(g->prefix);
+    free(g->tokens);
+}
+
+/**
+ * @brief Visitor state forwarding only the addresses a filter keeps.
+ */
+struct filter_walk {
+    const struct addr_filter *filter;
+    addr_visit_fn visit;
+    void *ctx;
+    size_t seen;        // addresses offered by the backend
+};
+
+/**
+ * @brief Visitor applying `struct filter_walk` before the real visitor.
+ *
+ * @param ai   Visited address.
+ * @param ctx  `struct filter_walk`.
+ * @return The wrapped visitor's result, 0 for dropped addresses.
+ */
+static int filter_visit(const struct addr_info *ai, void *ctx) {
+    struct filter_walk *fw = ctx;
+    fw->seen++;
+    return addr_filter_match(fw->filter, ai) ? fw->visit(ai, fw->ctx) : 0;
+}
+
+/**
+ * @brief Visit every IPv4/IPv6 entry of an `ifaddrs` list.
+ *
+ * The prefix is derived from each entry's netmask; `ifindex` is left at 0.
+ *
+ * @param ifaddr List to walk (from `getifaddrs`, or built by the benchmark).
+ * @param ifname Only visit entries with this name, or NULL for all.
+ * @param visit  Visitor called per address.
+ * @param ctx    Opaque pointer handed to the visitor.
+ */
+static void walk_ifaddrs(const struct ifaddrs *ifaddr, const char *ifname, addr_visit_fn visit, void *ctx) {
+    for (const struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = (*ifa).ifa_next) {
+        if (!(*ifa).ifa_addr) continue; // entry without address (e.g. interface without IP)
+        if (ifname && strcmp((*ifa).ifa_name, ifname) != 0) continue; // not the requested interface
+        struct addr_info ai = { .ifname = (*ifa).ifa_name, .family = (*ifa).ifa_addr->sa_family };
+        if (ai.family == AF_INET) {
+            memcpy(ai.addr, &((const struct sockaddr_in *)(*ifa).ifa_addr)->sin_addr, 4);
+        } else if (ai.family == AF_INET6) {
+            memcpy(ai.addr, &((const struct sockaddr_in6 *)(*ifa).ifa_addr)->sin6_addr, 16);
+        } else {
+            continue; // AF_PACKET / AF_LINK entries carry no IP
+        }
+        ai.prefix = count_prefix_length((*ifa).ifa_netmask);
+        ai.scope = addr_scope_of(ai.family, ai.addr);
+        if (visit(&ai, ctx)) break;
+    }
+}
+
+/**
+ * @brief Visit every IPv4/IPv6 address reported by libc `getifaddrs`.
+ *
+ * @param ifname Only visit entries with this name, or NULL for all.
+ * @param visit  Visitor called per address.
+ * @param ctx    Opaque pointer handed to the visitor.
+ * @return 0 on success; -1 if `getifaddrs` fails (errno set).
+ */
+static int enumerate_getifaddrs(const char *ifname, addr_visit_fn visit, void *ctx) {
+    struct ifaddrs *ifaddr = NULL;
+    if (getifaddrs(&ifaddr) == -1) return -1;
+    walk_ifaddrs(ifaddr, ifname, visit, ctx);
+    freeifaddrs(ifaddr); // -> Cleanup
+    return 0;
+}
+
+#ifdef HAVE_RT_IFLIST
+
+#if defined(__APPLE__)
+#define RT_SA_ALIGN sizeof(uint32_t) // sockaddr padding inside routing messages
+#elif defined(__NetBSD__)
+#define RT_SA_ALIGN sizeof(uint64_t)
+#else
+#define RT_SA_ALIGN sizeof(long)
+#endif
+
+/**
+ * @brief Bytes one sockaddr takes in a routing message (padded; a zero length still takes one unit).
+ */
+static size_t rt_sa_size(const struct sockaddr *sa) {
+    size_t len = sa->sa_len ? sa->sa_len : 1;
+    return (len + RT_SA_ALIGN - 1) & ~(RT_SA_ALIGN - 1);
+}
+
+/**
+ * @brief Locate the sockaddrs following a routing message header, by RTAX_* slot.
+ *
+ * @param p      First sockaddr.
+ * @param end    End of the message.
+ * @param addrs  RTA_* bits of the slots present, in slot order.
+ * @param sa     Receives one pointer per slot, NULL when absent or truncated.
+ */
+static void rt_sockaddrs(const unsigned char *p, const unsigned char *end, int addrs, const struct sockaddr *sa[RTAX_MAX]) {
+    for (int i = 0; i < RTAX_MAX; ++i) sa[i] = NULL;
+    for (int i = 0; i < RTAX_MAX; ++i) {
+        if (!(addrs & (1 << i))) continue;
+        if (end - p < 2 || (size_t)(end - p) < ((const struct sockaddr *)p)->sa_len) break; // sa_len and sa_family
+        sa[i] = (const struct sockaddr *)p;
+        p += rt_sa_size(sa[i]);
+    }
+}
+
+/**
+ * @brief Prefix length of a routing-message netmask.
+ *
+ * The kernel trims trailing zero bytes from netmasks and may leave their
+ * family unset, so the mask is first widened into a full sockaddr.
+ *
+ * @param mask    Netmask sockaddr, or NULL.
+ * @param family  Family of the address it belongs to.
+ * @return Same as count_prefix_length().
+ */
+static int rt_mask_prefix(const struct sockaddr *mask, int family) {
+    if (!mask) return -1;
+    struct sockaddr_in6 full; // large enough for either family
+    memset(&full, 0, sizeof(full));
+    memcpy(&full, mask, mask->sa_len < sizeof(full) ? mask->sa_len : sizeof(full));
+    full.sin6_family = (sa_family_t)family; // same offset as sin_family
+    return count_prefix_length((const struct sockaddr *)&full);
+}
+
+/**
+ * @brief Visit every IPv4/IPv6 address from one sysctl(NET_RT_IFLIST) snapshot.
+ *
+ * The kernel answers with an RTM_IFINFO message per interface (its name in
+ * a sockaddr_dl), each followed by one RTM_NEWADDR per address; these are
+ * parsed in place instead of being rebuilt into an `ifaddrs` list. With a
+ * single family or interface filtered, the sysctl itself is restricted.
+ *
+ * @param filter  Address filter (only its families are applied here).
+ * @param ifname  Only visit addresses of this interface, or NULL for all.
+ * @param visit   Visitor called per address.
+ * @param ctx     Opaque pointer handed to the visitor.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+static int enumerate_sysctl(const struct addr_filter *filter, const char *ifname, addr_visit_fn visit, void *ctx) {
+    int mib[6] = { CTL_NET, PF_ROUTE, 0, 0 /* family */, NET_RT_IFLIST, 0 /* ifindex */ };
+    if (filter->families == FILTER_INET) mib[3] = AF_INET;
+    if (filter->families == FILTER_INET6) mib[3] = AF_INET6;
+    if (ifname) {
+        mib[5] = (int)if_nametoindex(ifname);
+        if (mib[5] == 0) return 0; // no such interface: nothing to list
+    }
+    unsigned char *buf = NULL;
+    size_t len;
+    for (;;) { // the table may grow between sizing it and reading it
+        if (sysctl(mib, 6, NULL, &len, NULL, 0) != 0) {
+            free(buf);
+            return -1;
+        }
+        len += len / 8 + 1024;
+        buf = xrealloc(buf, len);
+        if (sysctl(mib, 6, buf, &len, NULL, 0) == 0) break;
+        if (errno != ENOMEM) {
+            int saved = errno;
+            free(buf);
+            errno = saved;
+            return -1;
+        }
+    }
+
+    char name[IF_NAMESIZE] = "";
+    unsigned int name_index = 0; // ifindex whose name is in `name`, 0 if none
+    const struct sockaddr *sa[RTAX_MAX];
+    for (size_t off = 0; len - off >= 4;) { // every message starts with its length, version and type
+        const struct if_msghdr *ifm = (const struct if_msghdr *)(buf + off);
+        size_t msglen = ifm->ifm_msglen;
+        if (msglen < 4 || msglen > len - off) break;
+        const unsigned char *end = buf + off + msglen;
+        off += msglen;
+        if (ifm->ifm_version != RTM_VERSION) continue;
+        if (ifm->ifm_type == RTM_IFINFO) {
+            if (msglen < sizeof(*ifm)) continue;
+#ifdef __OpenBSD__
+            rt_sockaddrs((const unsigned char *)ifm + ifm->ifm_hdrlen, end, ifm->ifm_addrs, sa);
+#else
+            rt_sockaddrs((const unsigned char *)(ifm + 1), end, ifm->ifm_addrs, sa);
+#endif
+            const struct sockaddr_dl *sdl = (const struct sockaddr_dl *)sa[RTAX_IFP];
+            if (sdl && sdl->sdl_family == AF_LINK && sdl->sdl_nlen > 0 && sdl->sdl_nlen < IF_NAMESIZE) {
+                memcpy(name, sdl->sdl_data, sdl->sdl_nlen);
+                name[sdl->sdl_nlen] = '\0';
+                name_index = ifm->ifm_index;
+            }
+            continue;
+        }
+        if (ifm->ifm_type != RTM_NEWADDR || msglen < sizeof(struct ifa_msghdr)) continue;
+        const struct ifa_msghdr *ifam = (const struct ifa_msghdr *)ifm;
+#ifdef __OpenBSD__
+        rt_sockaddrs((const unsigned char *)ifam + ifam->ifam_hdrlen, end, ifam->ifam_addrs, sa);
+#else
+        rt_sockaddrs((const unsigned char *)(ifam + 1), end, ifam->ifam_addrs, sa);
+#endif
+        const struct sockaddr *addr = sa[RTAX_IFA];
+        if (!addr) continue;
+        struct addr_info ai = { .ifname = name, .ifindex = ifam->ifam_index, .family = addr->sa_family };
+        if (ai.family == AF_INET && addr->sa_len >= sizeof(struct sockaddr_in)) {
+            memcpy(ai.addr, &((const struct sockaddr_in *)addr)->sin_addr, 4);
+        } else if (ai.family == AF_INET6 && addr->sa_len >= sizeof(struct sockaddr_in6)) {
+            memcpy(ai.addr, &((const struct sockaddr_in6 *)addr)->sin6_addr, 16);
+            if (ai.addr[0] == 0xfe && (ai.addr[1] & 0xc0) == 0x80) ai.addr[2] = ai.addr[3] = 0; // KAME embedded scope id
+        } else {
+            continue;
+        }
+        if (ai.ifindex != name_index) { // address without its RTM_IFINFO (should not happen)
+            if (!if_indextoname(ai.ifindex, name)) continue;
+            name_index = ai.ifindex;
+        }
+        ai.prefix = rt_mask_prefix(sa[RTAX_NETMASK], ai.family);
+        ai.scope = addr_scope_of(ai.family, ai.addr);
+        if (visit(&ai, ctx)) break;
+    }
+    free(buf);
+    return 0;
+}
+
+#endif /* HAVE_RT_IFLIST */
+
+/**
+ * @brief qsort/bsearch order of a link table: by name.
+ */
+static int link_cmp_name(const void *a, const void *b) {
+    return strcmp(((const struct link_stats *)a)->name, ((const struct link_stats *)b)->name);
+}
+
+/**
+ * @brief Find a link's counters by device name.
+ *
+ * @param t     Link table (sorted by name).
+ * @param name  Device name; alias labels ("eth0:1") have no entry.
+ * @return Counters, or NULL if there is no such link.
+ */
+const struct link_stats *link_table_find(const struct link_table *t, const char *name) {
+    struct link_stats key;
+    if (!t || strlen(name) >= sizeof(key.name)) return NULL;
+    snprintf(key.name, sizeof(key.name), "%s", name);
+    return bsearch(&key, t->links, t->count, sizeof(*t->links), link_cmp_name);
+}
+
+#if defined(__linux__) || defined(HAVE_RT_IFLIST) // the platforms with link entries to collect
+
+/**
+ * @brief Append a zeroed entry to a link table.
+ *
+ * @param t     Link table.
+ * @param name  Device name.
+ * @return The new entry.
+ */
+static struct link_stats *link_table_add(struct link_table *t, const char *name) {
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 32;
+        t->links = xrealloc(t->links, t->cap * sizeof(*t->links));
+    }
+    struct link_stats *ls = &t->links[t->count++];
+    memset(ls, 0, sizeof(*ls));
+    snprintf(ls->name, sizeof(ls->name), "%s", name);
+    return ls;
+}
+
+#endif
+
+/**
+ * @brief Read the link-layer state of every link from libc `getifaddrs`.
+ *
+ * Uses the AF_PACKET (Linux) or AF_LINK (BSD, macOS) entries: flags and
+ * hardware address, and the MTU from their `if_data` on BSD or one
+ * SIOCGIFMTU on Linux. Counters are left unreported.
+ *
+ * @param t  Link table to fill (zeroed); sorted by name on return.
+ * @return 0 on success; -1 if `getifaddrs` fails (errno set).
+ */
+int link_table_ifaddrs(struct link_table *t) {
+    struct ifaddrs *ifaddr = NULL;
+    if (getifaddrs(&ifaddr) == -1) return -1;
+#if defined(__linux__)
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0); // SIOCGIFMTU needs any socket
+    for (const struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_PACKET) continue;
+        const struct sockaddr_ll *sll = (const struct sockaddr_ll *)ifa->ifa_addr;
+        struct link_stats *ls = link_table_add(t, ifa->ifa_name);
+        ls->ifindex = (unsigned int)sll->sll_ifindex;
+        ls->flags = ifa->ifa_flags;
+        ls->hwlen = sll->sll_halen <= sizeof(sll->sll_addr) ? sll->sll_halen : 0;
+        memcpy(ls->hwaddr, sll->sll_addr, ls->hwlen);
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifa->ifa_name);
+        if (fd >= 0 && ioctl(fd, SIOCGIFMTU, &ifr) == 0) ls->mtu = (unsigned int)ifr.ifr_mtu;
+    }
+    if (fd >= 0) close(fd);
+#elif defined(HAVE_RT_IFLIST)
+    for (const struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_LINK) continue;
+        const struct sockaddr_dl *sdl = (const struct sockaddr_dl *)ifa->ifa_addr;
+        struct link_stats *ls = link_table_add(t, ifa->ifa_name);
+        ls->ifindex = sdl->sdl_index;
+        ls->flags = ifa->ifa_flags;
+        ls->hwlen = sdl->sdl_alen <= LINK_HWADDR_MAX ? sdl->sdl_alen : 0;
+        memcpy(ls->hwaddr, LLADDR(sdl), ls->hwlen);
+        if (ifa->ifa_data) ls->mtu = (unsigned int)((const struct if_data *)ifa->ifa_data)->ifi_mtu;
+    }
+#endif // other platforms list no link-layer entries: the table stays empty
+    freeifaddrs(ifaddr);
+    qsort(t->links, t->count, sizeof(*t->links), link_cmp_name);
+    return 0;
+}
+
+#ifdef __linux__
+
+#define NL_SOCK_RCVBUF (1 << 20)    // socket receive queue, so big dumps are not throttled
+
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK 12   // Linux >= 4.20, missing from older headers
+#endif
+
+/**
+ * @brief Open and bind an rtnetlink socket.
+ *
+ * Strict checking (NETLINK_GET_STRICT_CHK) is enabled once here, for every
+ * dump the socket will carry: the kernel then honours the ifindex of a
+ * filtered RTM_GETADDR dump, and the headers sent (a full ifaddrmsg or
+ * ifinfomsg, zeroed but for the filter) pass its checks. Kernels before 4.20
+ * ignore the option and dump everything, which nl_handle_addr() filters.
+ *
+ * @param nl  Socket to initialize.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+int nl_open(struct nl_sock *nl) {
+    nl->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (nl->fd < 0) return -1;
+    int rcvbuf = NL_SOCK_RCVBUF;
+    setsockopt(nl->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)); // best effort, the default still works
+    struct sockaddr_nl local = { .nl_family = AF_NETLINK };
+    if (bind(nl->fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        int saved = errno;
+        close(nl->fd);
+        errno = saved;
+        return -1;
+    }
+    int on = 1;
+    setsockopt(nl->fd, SOL_NETLINK, NETLINK_GET_STRICT_CHK, &on, sizeof(on)); // best effort, see above
+    nl->seq = 0;
+    nl->buf = xrealloc(NULL, NL_BUFSIZE);
+    return 0;
+}
+
+/**
+ * @brief Close an rtnetlink socket and release its buffer.
+ *
+ * @param nl  Socket to close.
+ */
+void nl_close(struct nl_sock *nl) {
+    close(nl->fd);
+    free(nl->buf);
+    nl->fd = -1;
+    nl->buf = NULL;
+}
+
+/**
+ * @brief Send a dump request with a fixed-size family header as payload.
+ *
+ * @param nl       Socket to send on; its sequence number is advanced.
+ * @param type     Request type (e.g. RTM_GETADDR).
+ * @param payload  Family header (e.g. `struct ifaddrmsg`).
+ * @param len      Size of the payload in bytes.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+static int nl_send_dump(struct nl_sock *nl, uint16_t type, const void *payload, size_t len) {
+    struct {
+        struct nlmsghdr nlh;
+        unsigned char payload[64];
+    } req;
+    if (len > sizeof(req.payload)) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(len);
+    req.nlh.nlmsg_type = type;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++nl->seq;
+    memcpy(req.payload, payload, len);
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    ssize_t n;
+    do {
+        n = sendto(nl->fd, &req, req.nlh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel));
+    } while (n < 0 && errno == EINTR);
+    return n < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Receive the answer to the last dump request and hand each message to a handler.
+ *
+ * Reads until NLMSG_DONE. Once the handler returns non-zero the remaining
+ * messages are still drained (but not handled) so the socket can be reused.
+ *
+ * @param nl      Socket the request was sent on.
+ * @param handle  Per-message handler; non-zero stops handling.
+ * @param ctx     Opaque pointer handed to the handler.
+ * @return 0 on success; -1 on failure (errno set, from the kernel on NLMSG_ERROR).
+ */
+static int nl_recv_dump(struct nl_sock *nl, int (*handle)(const struct nlmsghdr *, void *), void *ctx) {
+    int stopped = 0;
+    for (;;) {
+        ssize_t n = recv(nl->fd, nl->buf, NL_BUFSIZE, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        int len = (int)n;
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)nl->buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != nl->seq) continue; // stale answer to an earlier request
+            if (nlh->nlmsg_type == NLMSG_DONE) return 0;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr *err = NLMSG_DATA(nlh);
+                if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*err))) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                if (err->error == 0) continue; // plain ACK
+                errno = -err->error;
+                return -1;
+            }
+            if (!stopped && handle(nlh, ctx)) stopped = 1;
+        }
+    }
+}
+
+/**
+ * @brief Resolve an interface index to its name, caching the last lookup.
+ *
+ * The kernel dumps addresses device by device, so remembering the last index
+ * means one SIOCGIFNAME per device instead of a link dump.
+ *
+ * @param w        Walk state holding the cache and the socket used for the ioctl.
+ * @param ifindex  Interface index to resolve.
+ * @return Interface name (falls back to "if<index>" if it vanished meanwhile).
+ */
+static const char *nl_ifname(struct nl_addr_walk *w, unsigned int ifindex) {
+    if (w->name_index == ifindex) return w->name;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_ifindex = (int)ifindex;
+    if (ioctl(w->nl->fd, SIOCGIFNAME, &ifr) == 0) {
+        memcpy(w->name, ifr.ifr_name, IF_NAMESIZE);
+        w->name[IF_NAMESIZE - 1] = '\0';
+    } else if (!if_indextoname(ifindex, w->name)) {
+        snprintf(w->name, sizeof(w->name), "if%u", ifindex);
+    }
+    w->name_index = ifindex;
+    return w->name;
+}
+
+/**
+ * @brief Decode one RTM_NEWADDR/RTM_DELADDR message into an `addr_info`.
+ *
+ * Like glibc, IFA_LOCAL wins over IFA_ADDRESS (which is the peer on
+ * point-to-point links) and IFA_LABEL names IPv4 aliases. The walk's
+ * ifindex and name filters are applied.
+ *
+ * @param w    Walk state (filters and name cache); `ai->ifname` may point into it.
+ * @param nlh  Netlink message (RTM_NEWADDR or RTM_DELADDR).
+ * @param ai   Receives the decoded address.
+ * @return 0 if `ai` was filled; -1 if the message is skipped (malformed, other family, filtered out).
+ */
+int nl_parse_addr(struct nl_addr_walk *w, const struct nlmsghdr *nlh, struct addr_info *ai) {
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg))) return -1;
+    struct ifaddrmsg *ifm = NLMSG_DATA(nlh);
+    if (ifm->ifa_family != AF_INET && ifm->ifa_family != AF_INET6) return -1;
+    if (w->ifindex && ifm->ifa_index != w->ifindex) return -1; // kernel ignored the filter (no strict checking)
+    size_t alen = ifm->ifa_family == AF_INET ? 4 : 16;
+
+    const void *address = NULL, *local = NULL;
+    const char *label = NULL;
+    int rtlen = IFA_PAYLOAD(nlh);
+    for (struct rtattr *rta = IFA_RTA(ifm); RTA_OK(rta, rtlen); rta = RTA_NEXT(rta, rtlen)) {
+        size_t plen = RTA_PAYLOAD(rta);
+        switch (rta->rta_type) {
+            case IFA_ADDRESS:
+                if (plen >= alen) address = RTA_DATA(rta);
+                break;
+            case IFA_LOCAL:
+                if (plen >= alen) local = RTA_DATA(rta);
+                break;
+            case IFA_LABEL:
+                if (plen > 0 && plen <= IF_NAMESIZE && memchr(RTA_DATA(rta), '\0', plen)) label = RTA_DATA(rta);
+                break;
+        }
+    }
+    if (local) address = local;
+    if (!address) return -1;
+
+    const char *ifname = label ? label : nl_ifname(w, ifm->ifa_index);
+    if (w->ifname && strcmp(ifname, w->ifname) != 0) return -1;
+
+    memset(ai, 0, sizeof(*ai));
+    ai->ifname = ifname;
+    ai->ifindex = ifm->ifa_index;
+    ai->family = ifm->ifa_family;
+    ai->prefix = ifm->ifa_prefixlen;
+    switch (ifm->ifa_scope) {
+        case RT_SCOPE_HOST: ai->scope = SCOPE_HOST; break;
+        case RT_SCOPE_LINK: ai->scope = SCOPE_LINK; break;
+        case RT_SCOPE_SITE: ai->scope = SCOPE_SITE; break;
+        default: ai->scope = SCOPE_GLOBAL; break;
+    }
+    memcpy(ai->addr, address, alen);
+    return 0;
+}
+
+/**
+ * @brief Dump handler: decode one RTM_NEWADDR message and visit it.
+ *
+ * @param nlh  Netlink message.
+ * @param arg  `struct nl_addr_walk` state.
+ * @return The visitor's result (non-zero stops the walk); 0 for skipped messages.
+ */
+static int nl_handle_addr(const struct nlmsghdr *nlh, void *arg) {
+    struct nl_addr_walk *w = arg;
+    struct addr_info ai;
+    if (nlh->nlmsg_type != RTM_NEWADDR || nl_parse_addr(w, nlh, &ai) != 0) return 0;
+    return w->visit(&ai, w->ctx);
+}
+
+/**
+ * @brief Resolve an interface (or IPv4 alias) name to its index.
+ *
+ * Same as `if_nametoindex`, but reuses the netlink socket for the ioctl. The
+ * kernel strips an alias suffix ("eth0:1" resolves to eth0's index).
+ *
+ * @param nl    Socket used for the ioctl.
+ * @param name  Interface name.
+ * @return Interface index, or 0 if no such interface exists.
+ */
+static unsigned int nl_ifindex(struct nl_sock *nl, const char *name) {
+    struct ifreq ifr;
+    if (strlen(name) >= sizeof(ifr.ifr_name)) return 0;
+    memset(&ifr, 0, sizeof(ifr));
+    memcpy(ifr.ifr_name, name, strlen(name));
+    if (ioctl(nl->fd, SIOCGIFINDEX, &ifr) != 0) return 0;
+    return (unsigned int)ifr.ifr_ifindex;
+}
+
+/**
+ * @brief Visit IPv4/IPv6 addresses with a single RTM_GETADDR dump.
+ *
+ * No link dump is issued; names come from IFA_LABEL or a cached SIOCGIFNAME.
+ * With `ifname`, the name is resolved once and the dump is filtered by the
+ * kernel on that ifindex (strict checking, see nl_open()), so the cost is
+ * proportional to the addresses of that interface only.
+ *
+ * @param shared Socket to reuse, or NULL to open one for this dump.
+ * @param filter Only its family matters here; the caller applies the rest.
+ * @param ifname Only visit addresses of this interface or alias, or NULL for all.
+ * @param visit  Visitor called per address.
+ * @param ctx    Opaque pointer handed to the visitor.
+ * @return 0 on success (including an unknown `ifname`); -1 on failure (errno set).
+ */
+static int enumerate_netlink(struct nl_sock *shared, const struct addr_filter *filter, const char *ifname,
+                             addr_visit_fn visit, void *ctx) {
+    struct nl_sock own, *nl = shared;
+    if (!nl) {
+        if (nl_open(&own) != 0) return -1;
+        nl = &own;
+    }
+
+    struct ifaddrmsg ifm = { .ifa_family = AF_UNSPEC };
+    if (filter->families == FILTER_INET) ifm.ifa_family = AF_INET; // the kernel then dumps one family only
+    if (filter->families == FILTER_INET6) ifm.ifa_family = AF_INET6;
+    struct nl_addr_walk w = { .nl = nl, .visit = visit, .ctx = ctx, .ifname = ifname };
+    int rc = 0;
+    if (ifname) {
+        w.ifindex = nl_ifindex(nl, ifname);
+        if (w.ifindex == 0) { // no such interface: nothing to dump
+            if (!shared) nl_close(nl);
+            return 0;
+        }
+        ifm.ifa_index = w.ifindex; // honoured thanks to nl_open()'s strict checking; older kernels dump everything
+        if (!strchr(ifname, ':')) { // a device name, not an alias: no SIOCGIFNAME needed
+            w.name_index = w.ifindex;
+            snprintf(w.name, sizeof(w.name), "%s", ifname);
+        }
+    }
+    rc = nl_send_dump(nl, RTM_GETADDR, &ifm, sizeof(ifm));
+    if (rc == 0) rc = nl_recv_dump(nl, nl_handle_addr, &w);
+
+    int saved = errno;
+    if (!shared) nl_close(nl);
+    errno = saved;
+    return rc;
+}
+
+/**
+ * @brief Dump handler: record the counters and link-layer state of one RTM_NEWLINK message.
+ *
+ * @param nlh  Netlink message.
+ * @param arg  `struct link_table` to append to.
+ * @return Always 0 (keep handling).
+ */
+static int nl_handle_link(const struct nlmsghdr *nlh, void *arg) {
+    struct link_table *t = arg;
+    if (nlh->nlmsg_type != RTM_NEWLINK || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) return 0;
+    const struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+    const char *name = NULL;
+    const struct rtnl_link_stats64 *st = NULL;
+    struct rtnl_link_stats64 copy;
+    const struct rtattr *hw = NULL;
+    uint32_t mtu = 0;
+    int rtlen = (int)nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+    for (struct rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, rtlen); rta = RTA_NEXT(rta, rtlen)) {
+        size_t plen = RTA_PAYLOAD(rta);
+        if (rta->rta_type == IFLA_IFNAME && plen > 0 && plen <= IF_NAMESIZE && memchr(RTA_DATA(rta), '\0', plen)) {
+            name = RTA_DATA(rta);
+        } else if (rta->rta_type == IFLA_STATS64 && plen >= sizeof(copy)) {
+            memcpy(&copy, RTA_DATA(rta), sizeof(copy)); // attribute payloads are only 4-byte aligned
+            st = &copy;
+        } else if (rta->rta_type == IFLA_MTU && plen >= sizeof(mtu)) {
+            memcpy(&mtu, RTA_DATA(rta), sizeof(mtu));
+        } else if (rta->rta_type == IFLA_ADDRESS && plen <= LINK_HWADDR_MAX) {
+            hw = rta;
+        }
+    }
+    if (!name) return 0;
+    struct link_stats *ls = link_table_add(t, name);
+    ls->ifindex = (unsigned int)ifi->ifi_index;
+    ls->flags = ifi->ifi_flags;
+    ls->mtu = mtu;
+    if (hw) {
+        ls->hwlen = RTA_PAYLOAD(hw);
+        memcpy(ls->hwaddr, RTA_DATA(hw), ls->hwlen);
+    }
+    if (!st) return 0;
+    ls->counters = 1;
+    ls->rx_bytes = st->rx_bytes;
+    ls->rx_packets = st->rx_packets;
+    ls->rx_errors = st->rx_errors;
+    ls->rx_dropped = st->rx_dropped;
+    ls->tx_bytes = st->tx_bytes;
+    ls->tx_packets = st->tx_packets;
+    ls->tx_errors = st->tx_errors;
+    ls->tx_dropped = st->tx_dropped;
+    return 0;
+}
+
+/**
+ * @brief Read the counters and link-layer state of every link with one RTM_GETLINK dump.
+ *
+ * @param shared  Socket to reuse, or NULL to open one for this dump.
+ * @param t       Link table to fill (zeroed); sorted by name on return.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+static int link_table_dump(struct nl_sock *shared, struct link_table *t) {
+    struct nl_sock own, *nl = shared;
+    if (!nl) {
+        if (nl_open(&own) != 0) return -1;
+        nl = &own;
+    }
+    struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC };
+    int rc = nl_send_dump(nl, RTM_GETLINK, &ifi, sizeof(ifi));
+    if (rc == 0) rc = nl_recv_dump(nl, nl_handle_link, t);
+    int saved = errno;
+    if (!shared) nl_close(nl);
+    errno = saved;
+    if (rc == 0) qsort(t->links, t->count, sizeof(*t->links), link_cmp_name);
+    return rc;
+}
+
+#endif /* __linux__ */
+
+/**
+ * @brief Visit every IPv4/IPv6 address through a backend.
+ *
+ * Safe to call from worker threads: it only reports failure. Addresses
+ * rejected by the filter never reach `visit`.
+ *
+ * @param which   Backend.
+ * @param nl      Netlink socket to reuse, or NULL (ignored by the other backends).
+ * @param filter  Address filter (an empty one keeps everything).
+ * @param ifname  Only visit addresses of this interface, or NULL for all.
+ * @param visit   Visitor called per address.
+ * @param ctx     Opaque pointer handed to the visitor.
+ * @param seen    Incremented by the addresses the backend offered before filtering, or NULL.
+ * @return 0 on success; -1 on failure (errno set).
+ */
+int enumerate_with(enum backend which, struct nl_sock *nl, const struct addr_filter *filter, const char *ifname,
+                   addr_visit_fn visit, void *ctx, size_t *seen) {
+    struct filter_walk fw = { .filter = filter, .visit = visit, .ctx = ctx };
+    if (addr_filter_active(filter) || seen) { // the match is trivially true without filters
+        visit = filter_visit;
+        ctx = &fw;
+    }
+    int rc;
+#ifdef __linux__
+    if (which == BACKEND_NETLINK) {
+        rc = enumerate_netlink(nl, filter, ifname, visit, ctx);
+    } else
+#endif
+#ifdef HAVE_RT_IFLIST
+    if (which == BACKEND_SYSCTL) {
+        rc = enumerate_sysctl(filter, ifname, visit, ctx);
+    } else
+#endif
+    {
+        (void)nl;
+        rc = enumerate_getifaddrs(ifname, visit, ctx);
+    }
+    if (seen) *seen += fw.seen;
+    return rc;
+}
+
+/**
+ * @brief Read the counters of every link, when the platform can.
+ *
+ * @param nl  Netlink socket to reuse, or NULL.
+ * @param t   Link table to fill (zeroed).
+ * @return 0 on success; -1 on failure (errno set, ENOTSUP off Linux).
+ */
+int link_table_load_on(struct nl_sock *nl, struct link_table *t) {
+#ifdef __linux__
+    return link_table_dump(nl, t);
+#else
+    (void)nl;
+    (void)t;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Append a numeric address string (no DNS lookups involved).
+ *
+ * @param ob      Output buffer.
+ * @param family  AF_INET or AF_INET6.
+ * @param addr    Address bytes in network order.
+ * @return 0 on success; -1 if the address cannot be converted (nothing written).
+ */
+static int out_address(struct outbuf *ob, int family, const void *addr) {
+    int n = addr_to_string(family, addr, out_reserve(ob, INET6_ADDRSTRLEN), INET6_ADDRSTRLEN);
+    if (n < 0) return -1;
+    ob->len += (size_t)n;
+    return 0;
+}
+
+/**
+ * @brief Compute the dotted IPv4 netmask for a prefix length.
+ *
+ * @param prefix  Prefix length, 0..32.
+ * @return Mask in network byte order.
+ */
+static uint32_t ipv4_mask(int prefix) {
+    return htonl(prefix ? ~0U << (32 - prefix) : 0U);
+}
+
+/**
+ * @brief Print an interface header line.
+ *
+ * Prints the interface name followed by a colon (e.g., "eth0:") if the
+ * provided name is non-empty.
+ *
+ * @param ob      Output buffer.
+ * @param ifname  Interface name string. May be NULL or empty; prints nothing.
+ */
+static void print_interface_header(struct outbuf *ob, const char *ifname) {
+    if (ifname && *ifname) {
+        out_puts(ob, ifname);
+        out_write(ob, ":\n", 2);
+    }
+}
+
+/**
+ * @brief Append an address in "<addr>/<prefix>" form.
+ *
+ * For IPv4, also appends the dotted mask in parentheses, e.g.
+ * "192.0.2.10/24 (255.255.255.0)". Without a known prefix only the address
+ * is written; a non-contiguous netmask is flagged as
+ * "192.0.2.10 (non-contiguous netmask)" rather than shown as a prefix.
+ *
+ * @param ob  Output buffer.
+ * @param ai  Address to format.
+ * @return 0 on success; -1 if the address cannot be converted (nothing written).
+ */
+int format_address(struct outbuf *ob, const struct addr_info *ai) {
+    if (ai->family != AF_INET && ai->family != AF_INET6) return -1;
+    int prefix = ai->prefix;
+    // Worst case: IPv4 "255.255.255.255/32 (255.255.255.255)" or IPv6 text + "/128".
+    char *dst = out_reserve(ob, INET6_ADDRSTRLEN + 4 + INET_ADDRSTRLEN + 3);
+    size_t n = ai->family == AF_INET ? fmt_ipv4(dst, ai->addr) : fmt_ipv6(dst, ai->addr);
+    if (prefix == PREFIX_NONCONTIGUOUS) {
+        static const char flag[] = " (non-contiguous netmask)";
+        ob->len += n;
+        out_write(ob, flag, sizeof(flag) - 1);
+        return 0;
+    }
+    if (prefix >= 0) {
+        dst[n++] = '/';
+        n += fmt_small_uint(dst + n, (unsigned int)prefix);
+        if (ai->family == AF_INET && prefix <= 32) {
+            uint32_t mask = ipv4_mask(prefix); // dotted mask rebuilt from the prefix
+            dst[n++] = ' ';
+            dst[n++] = '(';
+            n += fmt_ipv4(dst + n, (const unsigned char *)&mask);
+            dst[n++] = ')';
+        }
+    }
+    ob->len += n;
+    return 0;
+}
+
+/**
+ * @brief Print a bullet line for an address.
+ *
+ * Renders a line in the form " - <addr>/<prefix>". For IPv4, also prints the
+ * dotted mask in parentheses, " - 192.0.2.10/24 (255.255.255.0)".
+ *
+ * @param ob  Output buffer.
+ * @param ai  Address to print. If NULL, no output.
+ */
+void print_address_bullet(struct outbuf *ob, const struct addr_info *ai) {
+    if (!ai) return;
+    size_t mark = ob->len;
+    out_puts(ob, " - ");
+    if (format_address(ob, ai) != 0) {
+        ob->len = mark; // unprintable address: drop the bullet
+        return;
+    }
+    out_puts(ob, "\n");
+}
+
+/**
+ * @brief Print one change line: "+ eth0 192.0.2.10/24 (255.255.255.0)".
+ *
+ * @param ob    Output buffer.
+ * @param sign  '+' for an added address, '-' for a removed one, '~' for a changed prefix.
+ * @param ai    Address that changed (its current value for '~').
+ */
+static void print_watch_event(struct outbuf *ob, char sign, const struct addr_info *ai) {
+    char lead[2] = { sign, ' ' };
+    out_write(ob, lead, 2);
+    out_puts(ob, ai->ifname);
+    out_write(ob, " ", 1);
+    format_address(ob, ai);
+    out_puts(ob, "\n");
+}
+
+/**
+ * @brief Append a JSON string literal, escaping as needed (no allocation).
+ *
+ * Bytes >= 0x80 are copied as-is; interface names are expected to be UTF-8.
+ *
+ * @param ob  Output buffer.
+ * @param s   NUL-terminated string.
+ */
+void json_string(struct outbuf *ob, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    out_puts(ob, "\"");
+    const char *run = s; // start of the pending run of bytes that need no escaping
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out_write(ob, run, (size_t)(s - run));
+        char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+        if (c == '"' || c == '\\') {
+            esc[1] = (char)c;
+            out_write(ob, esc, 2);
+        } else {
+            out_write(ob, esc, sizeof(esc));
+        }
+        run = s + 1;
+    }
+    out_write(ob, run, (size_t)(s - run));
+    out_puts(ob, "\"");
+}
+
+/**
+ * @brief Append the JSON members describing one address (without braces).
+ *
+ * Writes `"family":"inet","address":"192.0.2.10","prefix":24,"netmask":"255.255.255.0"`;
+ * `prefix` is null when unknown, `"noncontiguous_netmask":true` is added for
+ * a non-contiguous netmask, and `netmask` is only present for IPv4.
+ *
+ * @param ob  Output buffer.
+ * @param ai  Address to describe.
+ */
+void json_address_members(struct outbuf *ob, const struct addr_info *ai) {
+    out_puts(ob, ai->family == AF_INET ? "\"family\":\"inet\",\"address\":\"" : "\"family\":\"inet6\",\"address\":\"");
+    out_address(ob, ai->family, ai->addr);
+    if (ai->prefix < 0) {
+        out_puts(ob, ai->prefix == PREFIX_NONCONTIGUOUS ? "\",\"prefix\":null,\"noncontiguous_netmask\":true"
+                                                        : "\",\"prefix\":null");
+        return;
+    }
+    char num[3];
+    out_puts(ob, "\",\"prefix\":");
+    out_write(ob, num, fmt_small_uint(num, (unsigned int)ai->prefix));
+    if (ai->family == AF_INET && ai->prefix <= 32) {
+        uint32_t mask = ipv4_mask(ai->prefix);
+        out_puts(ob, ",\"netmask\":\"");
+        out_address(ob, AF_INET, &mask);
+        out_puts(ob, "\"");
+    }
+}
+
+/**
+ * @brief Print the counter lines of a link: " * rx <n> bytes, <n> packets, ...".
+ *
+ * @param ob  Output buffer.
+ * @param ls  Link counters.
+ */
+static void print_link_stats(struct outbuf *ob, const struct link_stats *ls) {
+    out_printf(ob, " * rx %" PRIu64 " bytes, %" PRIu64 " packets, %" PRIu64 " errors, %" PRIu64 " dropped\n",
+               ls->rx_bytes, ls->rx_packets, ls->rx_errors, ls->rx_dropped);
+    out_printf(ob, " * tx %" PRIu64 " bytes, %" PRIu64 " packets, %" PRIu64 " errors, %" PRIu64 " dropped\n",
+               ls->tx_bytes, ls->tx_packets, ls->tx_errors, ls->tx_dropped);
+}
+
+/**
+ * @brief Append the IFF_* names set in `flags`, separated by `sep` and each wrapped in `quote`.
+ *
+ * @param ob     Output buffer.
+ * @param flags  IFF_* bits.
+ * @param sep    Separator (",").
+ * @param quote  "" for text, "\"" for JSON.
+ * @param lead   Non-zero to also put `sep` before the first name (after text already written).
+ */
+static void out_link_flags(struct outbuf *ob, unsigned int flags, const char *sep, const char *quote, int lead) {
+    static const struct {
+        unsigned int bit;
+        const char *name;
+    } names[] = {
+        { IFF_UP, "UP" }, { IFF_BROADCAST, "BROADCAST" }, { IFF_LOOPBACK, "LOOPBACK" },
+        { IFF_POINTOPOINT, "POINTOPOINT" }, { IFF_RUNNING, "RUNNING" }, { IFF_NOARP, "NOARP" },
+        { IFF_PROMISC, "PROMISC" }, { IFF_MULTICAST, "MULTICAST" },
+#ifdef IFF_LOWER_UP
+        { IFF_LOWER_UP, "LOWER_UP" },
+#endif
+    };
+    int first = !lead;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (!(flags & names[i].bit)) continue;
+        out_printf(ob, "%s%s%s%s", first ? "" : sep, quote, names[i].name, quote);
+        first = 0;
+    }
+}
+
+/**
+ * @brief Append a hardware address as colon-separated hex bytes.
+ *
+ * @param ob  Output buffer.
+ * @param ls  Link with `hwlen` > 0.
+ */
+static void out_hwaddr(struct outbuf *ob, const struct link_stats *ls) {
+    static const char hex[] = "0123456789abcdef";
+    char *d = out_reserve(ob, ls->hwlen * 3);
+    for (size_t i = 0; i < ls->hwlen; ++i) {
+        *d++ = hex[ls->hwaddr[i] >> 4];
+        *d++ = hex[ls->hwaddr[i] & 0xf];
+        *d++ = ':';
+    }
+    ob->len += ls->hwlen * 3 - 1; // no colon after the last byte
+}
+
+/**
+ * @brief Print the link-layer line of a link: " * link UP,RUNNING,... mtu <n> hwaddr <mac>".
+ *
+ * @param ob  Output buffer.
+ * @param ls  Link.
+ */
+static void print_link_layer(struct outbuf *ob, const struct link_stats *ls) {
+    out_puts(ob, " * link ");
+    if (ls->flags & IFF_UP) {
+        out_link_flags(ob, ls->flags, ",", "", 0);
+    } else {
+        out_puts(ob, "DOWN");
+        out_link_flags(ob, ls->flags, ",", "", 1);
+    }
+    if (ls->mtu) out_printf(ob, " mtu %u", ls->mtu);
+    if (ls->hwlen) {
+        out_puts(ob, " hwaddr ");
+        out_hwaddr(ob, ls);
+    }
+    out_puts(ob, "\n");
+}
+
+/**
+ * @brief Append the JSON `"link":{...}` member of a link (without surrounding commas).
+ *
+ * @param ob  Output buffer.
+ * @param ls  Link.
+ */
+static void json_link_layer_member(struct outbuf *ob, const struct link_stats *ls) {
+    out_puts(ob, "\"link\":{\"flags\":[");
+    out_link_flags(ob, ls->flags, ",", "\"", 0);
+    out_puts(ob, "]");
+    if (ls->mtu) out_printf(ob, ",\"mtu\":%u", ls->mtu);
+    if (ls->hwlen) {
+        out_puts(ob, ",\"hwaddr\":\"");
+        out_hwaddr(ob, ls);
+        out_puts(ob, "\"");
+    }
+    out_puts(ob, "}");
+}
+
+/**
+ * @brief Append the JSON `"stats":{...}` member of a link (without surrounding commas).
+ *
+ * @param ob  Output buffer.
+ * @param ls  Link counters.
+ */
+static void json_link_stats_member(struct outbuf *ob, const struct link_stats *ls) {
+    out_printf(ob, "\"stats\":{\"rx_bytes\":%" PRIu64 ",\"rx_packets\":%" PRIu64 ",\"rx_errors\":%" PRIu64 ",\"rx_dropped\":%" PRIu64
+                   ",\"tx_bytes\":%" PRIu64 ",\"tx_packets\":%" PRIu64 ",\"tx_errors\":%" PRIu64 ",\"tx_dropped\":%" PRIu64 "}",
+               ls->rx_bytes, ls->rx_packets, ls->rx_errors, ls->rx_dropped,
+               ls->tx_bytes, ls->tx_packets, ls->tx_errors, ls->tx_dropped);
+}
+
+/**
+ * @brief Tell whether a link has anything to print for these fields.
+ *
+ * @param ls      Link, or NULL.
+ * @param fields  LINK_COUNTERS and/or LINK_LAYER.
+ */
+static int link_has_fields(const struct link_stats *ls, unsigned int fields) {
+    return ls && ((fields & LINK_LAYER) || ((fields & LINK_COUNTERS) && ls->counters));
+}
+
+/**
+ * @brief Append the JSON members a link table asks for, `"link":{...}` then `"stats":{...}`, comma-separated.
+ *
+ * @param ob      Output buffer.
+ * @param ls      Link, with link_has_fields() true.
+ * @param fields  LINK_COUNTERS and/or LINK_LAYER.
+ */
+static void json_link_members(struct outbuf *ob, const struct link_stats *ls, unsigned int fields) {
+    if (fields & LINK_LAYER) json_link_layer_member(ob, ls);
+    if ((fields & LINK_COUNTERS) && ls->counters) {
+        if (fields & LINK_LAYER) out_puts(ob, ",");
+        json_link_stats_member(ob, ls);
+    }
+}
+
+static void text_nop(struct printer *p) { (void)p; }
+
+static void text_interface_begin(struct printer *p, const char *ifname) {
+    print_interface_header(p->ob, ifname);
+}
+
+static void text_address(struct printer *p, const char *ifname, const struct addr_info *ai) {
+    (void)ifname;
+    print_address_bullet(p->ob, ai);
+}
+
+static void text_missing(struct printer *p, const char *ifname) {
+    const struct link_stats *ls = link_table_find(p->links, ifname);
+    if (ls && link_has_fields(ls, p->links->fields)) return; // the link lines below show it exists
+    out_printf(p->ob, "Interface '%s' not found or has no IP.\n", ifname);
+}
+
+static void text_interface_end(struct printer *p, const char *ifname) {
+    const struct link_stats *ls = link_table_find(p->links, ifname);
+    if (ls && (p->links->fields & LINK_LAYER)) print_link_layer(p->ob, ls);
+    if (ls && (p->links->fields & LINK_COUNTERS) && ls->counters) print_link_stats(p->ob, ls);
+    if (!p->single) out_puts(p->ob, "\n");
+}
+
+static void text_event(struct printer *p, char sign, const struct addr_info *ai) {
+    print_watch_event(p->ob, sign, ai);
+}
+
+static const struct printer_ops text_ops = {
+    1, text_nop, text_interface_begin, text_address, text_missing, text_interface_end, text_nop, text_event, NULL,
+};
+
+static void json_begin(struct printer *p) {
+    if (p->netns) { // one element of the --all-netns "namespaces" array
+        out_puts(p->ob, "{\"netns\":");
+        json_string(p->ob, p->netns);
+        out_puts(p->ob, ",\"interfaces\":[");
+        return;
+    }
+    out_puts(p->ob, "{\"interfaces\":[");
+}
+
+static void json_interface_begin(struct printer *p, const char *ifname) {
+    out_puts(p->ob, p->ifaces++ ? ",{\"ifname\":" : "{\"ifname\":");
+    json_string(p->ob, ifname);
+    out_puts(p->ob, ",\"addresses\":[");
+    p->addrs = 0;
+}
+
+static void json_address(struct printer *p, const char *ifname, const struct addr_info *ai) {
+    (void)ifname;
+    out_puts(p->ob, p->addrs++ ? ",{" : "{");
+    json_address_members(p->ob, ai);
+    out_puts(p->ob, "}");
+}
+
+static void json_missing(struct printer *p, const char *ifname) {
+    (void)p; (void)ifname; // an interface with an empty "addresses" array says it all
+}
+
+static void json_interface_end(struct printer *p, const char *ifname) {
+    const struct link_stats *ls = link_table_find(p->links, ifname);
+    if (ls && link_has_fields(ls, p->links->fields)) { // p->links is NULL without --stats / -l
+        out_puts(p->ob, "],");
+        json_link_members(p->ob, ls, p->links->fields);
+        out_puts(p->ob, "}");
+        return;
+    }
+    out_puts(p->ob, "]}");
+}
+
+static void json_end(struct printer *p) {
+    out_puts(p->ob, p->netns ? "]}" : "]}\n");
+}
+
+static const struct printer_ops json_ops = {
+    1, json_begin, json_interface_begin, json_address, json_missing, json_interface_end, json_end, NULL, NULL,
+};
+
+static void ndjson_address(struct printer *p, const char *ifname, const struct addr_info *ai) {
+    if (p->netns) {
+        out_puts(p->ob, "{\"netns\":");
+        json_string(p->ob, p->netns);
+        out_puts(p->ob, ",\"ifname\":");
+    } else {
+        out_puts(p->ob, "{\"ifname\":");
+    }
+    json_string(p->ob, ifname);
+    out_puts(p->ob, ",");
+    json_address_members(p->ob, ai);
+    out_puts(p->ob, "}\n");
+}
+
+/**
+ * @brief NDJSON: one `{"ifname":..,"link":{...},"stats":{...}}` record per link (after the addresses).
+ *
+ * @param p      Printer.
+ * @param links  Links to print, in order.
+ * @param count  Number of links.
+ */
+static void ndjson_links(struct printer *p, const struct link_stats *const *links, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (p->netns) {
+            out_puts(p->ob, "{\"netns\":");
+            json_string(p->ob, p->netns);
+            out_puts(p->ob, ",\"ifname\":");
+        } else {
+            out_puts(p->ob, "{\"ifname\":");
+        }
+        json_string(p->ob, links[i]->name);
+        out_puts(p->ob, ",");
+        json_link_members(p->ob, links[i], p->links->fields);
+        out_puts(p->ob, "}\n");
+    }
+}
+
+static void ndjson_event(struct printer *p, char sign, const struct addr_info *ai) {
+    out_puts(p->ob, sign == '+' ? "{\"event\":\"add\",\"ifname\":" :
+                    sign == '~' ? "{\"event\":\"change\",\"ifname\":" : "{\"event\":\"del\",\"ifname\":");
+    json_string(p->ob, ai->ifname);
+    out_puts(p->ob, ",");
+    json_address_members(p->ob, ai);
+    out_puts(p->ob, "}\n");
+}
+
+static const struct printer_ops ndjson_ops = {
+    0, text_nop, NULL, ndjson_address, NULL, NULL, text_nop, ndjson_event, ndjson_links,
+};
+
+/**
+ * @brief Append an OpenMetrics label value, quoted, escaping `\\`, `"` and newlines.
+ *
+ * @param ob  Output buffer.
+ * @param s   Label value.
+ */
+void openmetrics_label(struct outbuf *ob, const char *s) {
+    out_puts(ob, "\"");
+    const char *run = s; // start of the pending run of bytes that need no escaping
+    for (; *s; ++s) {
+        if (*s != '"' && *s != '\\' && *s != '\n') continue;
+        out_write(ob, run, (size_t)(s - run));
+        char esc[2] = { '\\', *s == '\n' ? 'n' : *s };
+        out_write(ob, esc, sizeof(esc));
+        run = s + 1;
+    }
+    out_write(ob, run, (size_t)(s - run));
+    out_puts(ob, "\"");
+}
+
+static void openmetrics_begin(struct printer *p) {
+    out_puts(p->ob, "# HELP ifshow_address_info IP address configured on an interface.\n"
+                    "# TYPE ifshow_address_info gauge\n");
+}
+
+static void openmetrics_address(struct printer *p, const char *ifname, const struct addr_info *ai) {
+    out_puts(p->ob, "ifshow_address_info{ifname=");
+    openmetrics_label(p->ob, ifname);
+    out_puts(p->ob, ai->family == AF_INET ? ",family=\"inet\",address=\"" : ",family=\"inet6\",address=\"");
+    out_address(p->ob, ai->family, ai->addr);
+    if (ai->prefix < 0) {
+        out_puts(p->ob, "\",prefix=\"\"} 1\n"); // no netmask, or a non-contiguous one
+        return;
+    }
+    char num[3];
+    out_puts(p->ob, "\",prefix=\"");
+    out_write(p->ob, num, fmt_small_uint(num, (unsigned int)ai->prefix));
+    out_puts(p->ob, "\"} 1\n");
+}
+
+/**
+ * @brief OpenMetrics: link-layer gauges (-l), then one counter family per IFLA_STATS64 field (--stats).
+ *
+ * Families must be contiguous, so the links are walked once per family.
+ * Every sample is labelled by link.
+ *
+ * @param p      Printer.
+ * @param links  Links to print, in order.
+ * @param count  Number of links.
+ */
+static void openmetrics_links(struct printer *p, const struct link_stats *const *links, size_t count) {
+    static const struct {
+        const char *name, *help;
+        size_t offset;
+    } counters[] = {
+        { "ifshow_link_receive_bytes", "Bytes received by the link.", offsetof(struct link_stats, rx_bytes) },
+        { "ifshow_link_receive_packets", "Packets received by the link.", offsetof(struct link_stats, rx_packets) },
+        { "ifshow_link_receive_errors", "Receive errors of the link.", offsetof(struct link_stats, rx_errors) },
+        { "ifshow_link_receive_dropped", "Received packets dropped by the link.", offsetof(struct link_stats, rx_dropped) },
+        { "ifshow_link_transmit_bytes", "Bytes sent by the link.", offsetof(struct link_stats, tx_bytes) },
+        { "ifshow_link_transmit_packets", "Packets sent by the link.", offsetof(struct link_stats, tx_packets) },
+        { "ifshow_link_transmit_errors", "Transmit errors of the link.", offsetof(struct link_stats, tx_errors) },
+        { "ifshow_link_transmit_dropped", "Sent packets dropped by the link.", offsetof(struct link_stats, tx_dropped) },
+    };
+    static const struct {
+        const char *name, *help;
+        unsigned int flag;      // IFF_* bit reported as 0/1, or 0 for the MTU
+    } gauges[] = {
+        { "ifshow_link_up", "Whether the link is administratively up.", IFF_UP },
+        { "ifshow_link_running", "Whether the link is operationally up.", IFF_RUNNING },
+        { "ifshow_link_mtu_bytes", "MTU of the link.", 0 },
+    };
+    if (p->links->fields & LINK_LAYER) {
+        out_puts(p->ob, "# HELP ifshow_link_info Hardware address and flags of a link.\n# TYPE ifshow_link_info gauge\n");
+        for (size_t i = 0; i < count; ++i) {
+            out_puts(p->ob, "ifshow_link_info{ifname=");
+            openmetrics_label(p->ob, links[i]->name);
+            out_puts(p->ob, ",hwaddr=\"");
+            if (links[i]->hwlen) out_hwaddr(p->ob, links[i]);
+            out_puts(p->ob, "\",flags=\"");
+            out_link_flags(p->ob, links[i]->flags, ",", "", 0);
+            out_puts(p->ob, "\"} 1\n");
+        }
+        for (size_t g = 0; g < sizeof(gauges) / sizeof(gauges[0]); ++g) {
+            out_printf(p->ob, "# HELP %s %s\n# TYPE %s gauge\n", gauges[g].name, gauges[g].help, gauges[g].name);
+            for (size_t i = 0; i < count; ++i) {
+                if (!gauges[g].flag && !links[i]->mtu) continue; // unknown MTU
+                out_printf(p->ob, "%s{ifname=", gauges[g].name);
+                openmetrics_label(p->ob, links[i]->name);
+                out_printf(p->ob, "} %u\n", gauges[g].flag ? (links[i]->flags & gauges[g].flag) != 0 : links[i]->mtu);
+            }
+        }
+    }
+    if (!(p->links->fields & LINK_COUNTERS)) return;
+    for (size_t c = 0; c < sizeof(counters) / sizeof(counters[0]); ++c) {
+        out_printf(p->ob, "# HELP %s %s\n# TYPE %s counter\n", counters[c].name, counters[c].help, counters[c].name);
+        for (size_t i = 0; i < count; ++i) {
+            if (!links[i]->counters) continue;
+            uint64_t value;
+            memcpy(&value, (const unsigned char *)links[i] + counters[c].offset, sizeof(value));
+            out_printf(p->ob, "%s_total{ifname=", counters[c].name);
+            openmetrics_label(p->ob, links[i]->name);
+            out_printf(p->ob, "} %" PRIu64 "\n", value);
+        }
+    }
+}
+
+static void openmetrics_end(struct printer *p) {
+    out_puts(p->ob, "# EOF\n");
+}
+
+static const struct printer_ops openmetrics_ops = {
+    0, openmetrics_begin, NULL, openmetrics_address, NULL, NULL, openmetrics_end, NULL, openmetrics_links,
+};
+
+/*
+ * --format=bin: one self-describing document, little-endian, 8-byte aligned
+ * sections, meant to be mmap()ed and indexed in place.
+ *
+ *   header (BIN_HEADER_SIZE bytes)
+ *      0  magic BIN_MAGIC
+ *      8  u64 document size, header included (frames concatenated documents)
+ *     16  u16 version (BIN_VERSION), u16 header size, u16 name entry size, u16 record size
+ *     24  u32 name count, u32 record count, u32 string table size (multiple of 8), u32 flags (0)
+ *   name entries (BIN_NAME_SIZE bytes each), in output order
+ *      u32 string offset, u32 first record, u32 record count, u32 ifindex (0 if unknown)
+ *   string table: NUL-terminated interface names, zero-padded to a multiple of 8
+ *   records (BIN_RECORD_SIZE bytes each), grouped by name entry
+ *      16 address bytes (network order, IPv4 in the first 4), u32 name index,
+ *      i16 prefix (as in `struct addr_info`), u8 family (4 or 6), u8 scope (enum addr_scope)
+ *
+ * Fields may be appended to the header, name entries and records without a
+ * version change: readers skip the bytes past the sizes they know.
+ */
+#define BIN_MAGIC "IFSHOWB1"
+#define BIN_VERSION 1
+#define BIN_HEADER_SIZE 40
+#define BIN_NAME_SIZE 16
+#define BIN_RECORD_SIZE 24
+
+static void put_le16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_le32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_le64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint16_t get_le16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const unsigned char *p) {
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+/**
+ * @brief A --format=bin document being assembled (sections are only known at the end).
+ */
+struct bin_doc {
+    struct outbuf names, strings, records;  // memory-only sections
+    uint32_t name_count, record_count;
+};
+
+static void bin_begin(struct printer *p) {
+    p->bin = xrealloc(NULL, sizeof(*p->bin));
+    memset(p->bin, 0, sizeof(*p->bin));
+    p->bin->names.fd = p->bin->strings.fd = p->bin->records.fd = -1;
+}
+
+static void bin_interface_begin(struct printer *p, const char *ifname) {
+    struct bin_doc *d = p->bin;
+    unsigned char *e = (unsigned char *)out_reserve(&d->names, BIN_NAME_SIZE);
+    put_le32(e, (uint32_t)d->strings.len);
+    put_le32(e + 4, d->record_count);
+    put_le32(e + 8, 0);
+    put_le32(e + 12, 0);
+    d->names.len += BIN_NAME_SIZE;
+    d->name_count++;
+    out_write(&d->strings, ifname, strlen(ifname) + 1);
+}
+
+static void bin_address(struct printer *p, const char *ifname, const struct addr_info *ai) {
+    (void)ifname;
+    struct bin_doc *d = p->bin;
+    unsigned char *e = (unsigned char *)d->names.data + (size_t)(d->name_count - 1) * BIN_NAME_SIZE;
+    put_le32(e + 8, get_le32(e + 8) + 1);
+    if (!get_le32(e + 12)) put_le32(e + 12, ai->ifindex);
+    unsigned char *r = (unsigned char *)out_reserve(&d->records, BIN_RECORD_SIZE);
+    memcpy(r, ai->addr, 16);
+    put_le32(r + 16, d->name_count - 1);
+    put_le16(r + 20, (uint16_t)(int16_t)ai->prefix);
+    r[22] = ai->family == AF_INET ? 4 : 6;
+    r[23] = (unsigned char)ai->scope;
+    d->records.len += BIN_RECORD_SIZE;
+    d->record_count++;
+}
+
+static void bin_end(struct printer *p) {
+    struct bin_doc *d = p->bin;
+    static const char pad[8];
+    out_write(&d->strings, pad, (8 - d->strings.len % 8) % 8);
+    unsigned char h[BIN_HEADER_SIZE] = {0};
+    memcpy(h, BIN_MAGIC, 8);
+    put_le64(h + 8, (uint64_t)BIN_HEADER_SIZE + d->names.len + d->strings.len + d->records.len);
+    put_le16(h + 16, BIN_VERSION);
+    put_le16(h + 18, BIN_HEADER_SIZE);
+    put_le16(h + 20, BIN_NAME_SIZE);
+    put_le16(h + 22, BIN_RECORD_SIZE);
+    put_le32(h + 24, d->name_count);
+    put_le32(h + 28, d->record_count);
+    put_le32(h + 32, (uint32_t)d->strings.len);
+    out_write(p->ob, h, sizeof(h));
+    out_write(p->ob, d->names.data, d->names.len);
+    out_write(p->ob, d->strings.data, d->strings.len);
+    out_write(p->ob, d->records.data, d->records.len);
+    free(d->names.data);
+    free(d->strings.data);
+    free(d->records.data);
+    free(d);
+    p->bin = NULL;
+}
+
+static void bin_interface_nop(struct printer *p, const char *ifname) { // the name entry holds the record count
+    (void)p;
+    (void)ifname;
+}
+
+static const struct printer_ops bin_ops = {
+    1, bin_begin, bin_interface_begin, bin_address, bin_interface_nop, bin_interface_nop, bin_end, NULL, NULL,
+};
+
+/**
+ * @brief Printer implementation of an output format.
+ */
+const struct printer_ops *printer_ops_for(enum output_format format) {
+    switch (format) {
+        case FORMAT_JSON: return &json_ops;
+        case FORMAT_NDJSON: return &ndjson_ops;
+        case FORMAT_OPENMETRICS: return &openmetrics_ops;
+        case FORMAT_BIN: return &bin_ops;
+        default: return &text_ops;
+    }
+}
+
+#define ARENA_BLOCK 65536 // bytes per arena block; larger requests get a block of their own
+
+/**
+ * @brief Allocate from an arena (16-byte aligned, never fails).
+ *
+ * @param a     Arena.
+ * @param size  Bytes wanted.
+ * @return Uninitialized storage, valid until arena_free().
+ */
+void *arena_alloc(struct arena *a, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    struct arena_block *b = a->head;
+    if (b && b->cap - b->used >= size) {
+        void *ptr = (unsigned char *)b->data + b->used;
+        b->used += size;
+        return ptr;
+    }
+    size_t cap = size > ARENA_BLOCK / 4 ? size : ARENA_BLOCK;
+    struct arena_block *nb = xrealloc(NULL, sizeof(*nb) + cap);
+    nb->used = size;
+    nb->cap = cap;
+    if (b && cap == size) { // dedicated block: keep carving small allocations from the current one
+        nb->next = b->next;
+        b->next = nb;
+    } else {
+        nb->next = b;
+        a->head = nb;
+    }
+    return nb->data;
+}
+
+/**
+ * @brief Grow an arena allocation, in place when it is the last one carved.
+ *
+ * @param a         Arena.
+ * @param ptr       Allocation to grow, or NULL.
+ * @param old_size  Its current size.
+ * @param new_size  Wanted size (>= old_size).
+ * @return Storage holding the old contents.
+ */
+static void *arena_grow(struct arena *a, void *ptr, size_t old_size, size_t new_size) {
+    struct arena_block *b = a->head;
+    size_t old_rounded = (old_size + 15) & ~(size_t)15, new_rounded = (new_size + 15) & ~(size_t)15;
+    if (ptr && b && (unsigned char *)ptr + old_rounded == (unsigned char *)b->data + b->used
+        && b->cap - b->used >= new_rounded - old_rounded) {
+        b->used += new_rounded - old_rounded;
+        return ptr;
+    }
+    void *grown = arena_alloc(a, new_size);
+    if (ptr) memcpy(grown, ptr, old_size);
+    return grown;
+}
+
+/**
+ * @brief Release every block of an arena.
+ *
+ * @param a  Arena (left empty and reusable).
+ */
+static void arena_free(struct arena *a) {
+    for (struct arena_block *b = a->head, *next; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+    a->head = NULL;
+}
+
+/**
+ * @brief FNV-1a hash of an interface name.
+ *
+ * @param s  NUL-terminated name.
+ * @return 32-bit hash value.
+ */
+static uint32_t hash_name(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Double the name hash and reinsert every name.
+ *
+ * @param s  Snapshot.
+ */
+static void snapshot_rehash(struct snapshot *s) {
+    uint32_t slot_count = s->slots ? (s->slot_mask + 1) * 2 : 64;
+    s->slots = arena_alloc(&s->arena, slot_count * sizeof(*s->slots));
+    memset(s->slots, 0, slot_count * sizeof(*s->slots));
+    s->slot_mask = slot_count - 1;
+    for (uint32_t n = 0; n < s->name_count; ++n) {
+        uint32_t i = s->names[n].hash & s->slot_mask;
+        while (s->slots[i]) i = (i + 1) & s->slot_mask; // linear probing
+        s->slots[i] = n + 1;
+    }
+}
+
+/**
+ * @brief Find an interned name.
+ *
+ * @param s     Snapshot.
+ * @param name  Interface name.
+ * @param hash  hash_name(name).
+ * @param slot  Receives the slot holding it, or the empty slot where it would go.
+ * @return Name index, or SNAP_NONE.
+ */
+static uint32_t snapshot_probe(const struct snapshot *s, const char *name, uint32_t hash, uint32_t *slot) {
+    uint32_t i = hash & s->slot_mask;
+    while (s->slots[i]) {
+        const struct snap_name *n = &s->names[s->slots[i] - 1];
+        if (n->hash == hash && strcmp(n->name, name) == 0) break;
+        i = (i + 1) & s->slot_mask;
+    }
+    *slot = i;
+    return s->slots[i] ? s->slots[i] - 1 : SNAP_NONE;
+}
+
+/**
+ * @brief Look a name up without interning it.
+ *
+ * @param s     Snapshot.
+ * @param name  Interface name.
+ * @return Name index, or SNAP_NONE.
+ */
+uint32_t snapshot_find(const struct snapshot *s, const char *name) {
+    uint32_t slot;
+    return s->slots ? snapshot_probe(s, name, hash_name(name), &slot) : SNAP_NONE;
+}
+
+/**
+ * @brief Intern a name, copying it into the arena on first sight.
+ *
+ * @param s     Snapshot.
+ * @param name  Interface name (backends only lend their storage).
+ * @return Name index.
+ */
+uint32_t snapshot_intern(struct snapshot *s, const char *name) {
+    if (!s->slots || (s->name_count + 1) * 2 > s->slot_mask + 1) snapshot_rehash(s); // keep load <= 50%
+    uint32_t hash = hash_name(name), slot;
+    uint32_t idx = snapshot_probe(s, name, hash, &slot);
+    if (idx != SNAP_NONE) return idx;
+    if (s->name_count == s->name_cap) {
+        uint32_t cap = s->name_cap ? s->name_cap * 2 : 16;
+        s->names = arena_grow(&s->arena, s->names, s->name_cap * sizeof(*s->names), cap * sizeof(*s->names));
+        s->name_cap = cap;
+    }
+    size_t len = strlen(name) + 1;
+    char *copy = arena_alloc(&s->arena, len);
+    memcpy(copy, name, len);
+    struct snap_name *n = &s->names[s->name_count];
+    n->name = copy;
+    n->hash = hash;
+    n->count = 0;
+    n->first = 0;
+    s->slots[slot] = ++s->name_count;
+    return s->name_count - 1;
+}
+
+/**
+ * @brief Append an address as a compact record.
+ *
+ * @param s     Snapshot.
+ * @param name  Interned name index.
+ * @param ai    Address to copy.
+ */
+void snapshot_append(struct snapshot *s, uint32_t name, const struct addr_info *ai) {
+    if (s->addr_count == s->addr_cap) {
+        uint32_t cap = s->addr_cap ? s->addr_cap * 2 : 64;
+        s->addrs = arena_grow(&s->arena, s->addrs, s->addr_cap * sizeof(*s->addrs), cap * sizeof(*s->addrs));
+        s->addr_cap = cap;
+    }
+    struct snap_addr *r = &s->addrs[s->addr_count++];
+    memcpy(r->addr, ai->addr, sizeof(r->addr));
+    r->ifindex = ai->ifindex;
+    r->name = name;
+    r->prefix = (int16_t)ai->prefix;
+    r->family = (uint8_t)ai->family;
+    r->scope = (uint8_t)ai->scope;
+    s->names[name].count++;
+    s->order = NULL; // grouping is stale
+}
+
+/**
+ * @brief Visitor appending every address to a snapshot.
+ *
+ * @param ai   Visited address.
+ * @param ctx  `struct snapshot` to fill.
+ * @return Always 0 (keep enumerating).
+ */
+int snapshot_add(const struct addr_info *ai, void *ctx) {
+    struct snapshot *s = ctx;
+    snapshot_append(s, snapshot_intern(s, ai->ifname), ai);
+    return 0;
+}
+
+/**
+ * @brief Visitor appending an address only if its name is already interned.
+ *
+ * @param ai   Visited address.
+ * @param ctx  `struct snapshot` pre-seeded with the wanted names.
+ * @return Always 0 (keep enumerating).
+ */
+int snapshot_add_known(const struct addr_info *ai, void *ctx) {
+    struct snapshot *s = ctx;
+    uint32_t name = snapshot_find(s, ai->ifname);
+    if (name != SNAP_NONE) snapshot_append(s, name, ai);
+    return 0;
+}
+
+/**
+ * @brief Visitor counting one address per family, without formatting it.
+ *
+ * @param ai   Visited address.
+ * @param ctx  `struct count_table`.
+ * @return Non-zero (stop enumerating) when --exists has found every name.
+ */
+int count_visit(const struct addr_info *ai, void *ctx) {
+    struct count_table *t = ctx;
+    uint32_t n = t->known_only ? snapshot_find(&t->names, ai->ifname) : snapshot_intern(&t->names, ai->ifname);
+    if (n == SNAP_NONE) return 0;
+    if (n >= t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 64;
+        t->entries = xrealloc(t->entries, cap * sizeof(*t->entries));
+        memset(t->entries + t->cap, 0, (cap - t->cap) * sizeof(*t->entries));
+        t->cap = cap;
+    }
+    struct count_entry *e = &t->entries[n];
+    e->name = n;
+    if (!e->ifindex) e->ifindex = ai->ifindex;
+    int first = !e->inet && !e->inet6;
+    if (ai->family == AF_INET) {
+        e->inet++;
+    } else {
+        e->inet6++;
+    }
+    return first && t->missing && --t->missing == 0; // --exists: every name answered
+}
+
+/**
+ * @brief Prepare a count table for the requested names.
+ *
+ * With names, only those interfaces are counted; `stop_when_found` makes
+ * count_visit() stop as soon as each of them has shown one address.
+ *
+ * @param t                Zeroed table.
+ * @param names            Interface names, or NULL for every interface.
+ * @param count            Number of names.
+ * @param stop_when_found  --exists: stop at the first address of the last name found.
+ */
+void count_table_seed(struct count_table *t, const char *const *names, size_t count, int stop_when_found) {
+    for (size_t i = 0; i < count; ++i) snapshot_intern(&t->names, names[i]);
+    t->cap = t->names.name_count;
+    if (t->cap) t->entries = xrealloc(NULL, t->cap * sizeof(*t->entries));
+    for (size_t i = 0; i < t->cap; ++i) t->entries[i] = (struct count_entry){ .name = (uint32_t)i };
+    t->known_only = count > 0;
+    if (stop_when_found) t->missing = t->names.name_count;
+}
+
+/**
+ * @brief Intern every link with something to print, so grouped formats list links without addresses too.
+ *
+ * Streaming formats report every link of the table (print_snapshot_links());
+ * this gives grouped ones the same set for an unseeded snapshot. New names
+ * follow the enumerated ones, in link-table order. Call it before
+ * snapshot_sort() / snapshot_group().
+ *
+ * @param s  Unseeded snapshot, filled.
+ * @param t  Links loaded for --stats / -l.
+ */
+void snapshot_add_links(struct snapshot *s, const struct link_table *t) {
+    for (size_t i = 0; i < t->count; ++i) {
+        if (link_has_fields(&t->links[i], t->fields)) snapshot_intern(s, t->links[i].name);
+    }
+}
+
+/**
+ * @brief Group the addresses by name (stable counting sort into `order`).
+ *
+ * Names keep their first-seen (or seeded) order and each name's addresses
+ * keep their backend order.
+ *
+ * @param s  Snapshot.
+ */
+void snapshot_group(struct snapshot *s) {
+    uint32_t *order = arena_alloc(&s->arena, (s->addr_count ? s->addr_count : 1) * sizeof(*order));
+    uint32_t next = 0;
+    for (uint32_t n = 0; n < s->name_count; ++n) {
+        s->names[n].first = next;
+        next += s->names[n].count;
+    }
+    uint32_t *fill = arena_alloc(&s->arena, (s->name_count ? s->name_count : 1) * sizeof(*fill));
+    for (uint32_t n = 0; n < s->name_count; ++n) fill[n] = s->names[n].first;
+    for (uint32_t i = 0; i < s->addr_count; ++i) order[fill[s->addrs[i].name]++] = i;
+    s->order = order;
+}
+
+#define SORT_KEY_LEN 26 // ifindex(4) name rank(4) family(1) address(16) prefix(1)
+
+/**
+ * @brief qsort order of `struct snap_name` pointers by name.
+ */
+static int snapshot_cmp_names(const void *a, const void *b) {
+    return strcmp((*(const struct snap_name *const *)a)->name, (*(const struct snap_name *const *)b)->name);
+}
+
+/**
+ * @brief Stable LSD radix sort of record indices on fixed-length byte keys.
+ *
+ * Byte positions where every key is equal are skipped, so constant fields
+ * (e.g. the ifindex with --sort=addr) cost one counting pass each.
+ *
+ * @param keys  `n` keys of SORT_KEY_LEN bytes; key `i` belongs to record `i`.
+ * @param perm  Record indices to sort (n entries).
+ * @param tmp   Scratch space for n indices.
+ * @param n     Number of records.
+ * @return `perm` or `tmp`, whichever holds the sorted indices.
+ */
+static uint32_t *radix_sort(const unsigned char *keys, uint32_t *perm, uint32_t *tmp, uint32_t n) {
+    for (int pos = SORT_KEY_LEN - 1; pos >= 0; --pos) {
+        uint32_t count[256] = {0};
+        for (uint32_t i = 0; i < n; ++i) count[keys[(size_t)perm[i] * SORT_KEY_LEN + pos]]++;
+        if (count[keys[(size_t)perm[0] * SORT_KEY_LEN + pos]] == n) continue; // all equal here
+        uint32_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            uint32_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (uint32_t i = 0; i < n; ++i) tmp[count[keys[(size_t)perm[i] * SORT_KEY_LEN + pos]]++] = perm[i];
+        uint32_t *swap = perm;
+        perm = tmp;
+        tmp = swap;
+    }
+    return perm;
+}
+
+/**
+ * @brief Reorder a snapshot (no-op for SORT_NONE).
+ *
+ * Records are radix-sorted on a binary key, then names are renumbered in
+ * the order their first record appears (names without records keep their
+ * relative order at the end), so both grouped and streaming output are
+ * fully determined by the addresses present. Must run before
+ * snapshot_group().
+ *
+ * @param s      Snapshot.
+ * @param order  Order to apply, usually the --sort value.
+ */
+void snapshot_sort(struct snapshot *s, enum sort_order order) {
+    if (order == SORT_NONE) return;
+    uint32_t n = s->addr_count, names = s->name_count;
+    // Name ranks in strcmp order: ties between aliases sharing an ifindex, and the whole key for SORT_NAME.
+    const struct snap_name **by_name = arena_alloc(&s->arena, (names ? names : 1) * sizeof(*by_name));
+    uint32_t *rank = arena_alloc(&s->arena, (names ? names : 1) * sizeof(*rank));
+    for (uint32_t i = 0; i < names; ++i) by_name[i] = &s->names[i];
+    qsort(by_name, names, sizeof(*by_name), snapshot_cmp_names);
+    for (uint32_t i = 0; i < names; ++i) rank[by_name[i] - s->names] = i;
+    if (order == SORT_INDEX) { // getifaddrs reports no index: resolve once per name
+        uint32_t *index = arena_alloc(&s->arena, (names ? names : 1) * sizeof(*index));
+        for (uint32_t i = 0; i < names; ++i) index[i] = SNAP_NONE;
+        for (uint32_t i = 0; i < n; ++i) {
+            struct snap_addr *r = &s->addrs[i];
+            if (r->ifindex) continue;
+            if (index[r->name] == SNAP_NONE) index[r->name] = if_nametoindex(s->names[r->name].name);
+            r->ifindex = index[r->name];
+        }
+    }
+
+    unsigned char *keys = arena_alloc(&s->arena, (n ? n : 1) * (size_t)SORT_KEY_LEN);
+    for (uint32_t i = 0; i < n; ++i) {
+        const struct snap_addr *r = &s->addrs[i];
+        unsigned char *k = keys + (size_t)i * SORT_KEY_LEN, *a = k;
+        uint32_t idx = order == SORT_INDEX ? r->ifindex : 0, nr = rank[r->name];
+        unsigned char fam = r->family == AF_INET ? 0 : 1, pfx = (unsigned char)(r->prefix + 2); // -2..128 -> 0..130
+        if (order == SORT_ADDR) { // address first, the interface only breaks ties
+            *a++ = fam;
+            memcpy(a, r->addr, 16);
+            a += 16;
+            *a++ = pfx;
+        }
+        for (int b = 3; b >= 0; --b) *a++ = (unsigned char)(idx >> (8 * b)); // big-endian: byte order is numeric order
+        for (int b = 3; b >= 0; --b) *a++ = (unsigned char)(nr >> (8 * b));
+        if (order != SORT_ADDR) {
+            *a++ = fam;
+            memcpy(a, r->addr, 16);
+            a += 16;
+            *a++ = pfx;
+        }
+    }
+    uint32_t *perm = arena_alloc(&s->arena, (n ? n : 1) * sizeof(*perm) * 2);
+    for (uint32_t i = 0; i < n; ++i) perm[i] = i;
+    uint32_t *sorted = n ? radix_sort(keys, perm, perm + n, n) : perm;
+
+    // Renumber names by first appearance in the sorted records.
+    uint32_t *renum = arena_alloc(&s->arena, (names ? names : 1) * sizeof(*renum));
+    for (uint32_t i = 0; i < names; ++i) renum[i] = SNAP_NONE;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t old = s->addrs[sorted[i]].name;
+        if (renum[old] == SNAP_NONE) renum[old] = next++;
+    }
+    for (uint32_t i = 0; i < names; ++i) {
+        if (renum[i] == SNAP_NONE) renum[i] = next++;
+    }
+    struct snap_name *new_names = arena_alloc(&s->arena, (names ? names : 1) * sizeof(*new_names));
+    for (uint32_t i = 0; i < names; ++i) new_names[renum[i]] = s->names[i];
+    struct snap_addr *new_addrs = arena_alloc(&s->arena, (n ? n : 1) * sizeof(*new_addrs));
+    for (uint32_t i = 0; i < n; ++i) {
+        new_addrs[i] = s->addrs[sorted[i]];
+        new_addrs[i].name = renum[new_addrs[i].name];
+    }
+    s->names = new_names;
+    s->name_cap = names;
+    s->addrs = new_addrs;
+    s->addr_cap = n;
+    if (s->slots) { // name indices changed: refill the table at its current size
+        memset(s->slots, 0, (s->slot_mask + 1) * sizeof(*s->slots));
+        for (uint32_t i = 0; i < names; ++i) {
+            uint32_t slot = s->names[i].hash & s->slot_mask;
+            while (s->slots[slot]) slot = (slot + 1) & s->slot_mask;
+            s->slots[slot] = i + 1;
+        }
+    }
+    s->order = NULL;
+}
+
+/**
+ * @brief One block of --summarize: a prefix and the records it covers.
+ */
+struct summary_block {
+    unsigned char net[16];      // address bytes; for a mergeable block, zero past `len`
+    int len;                    // prefix length (the full width without a usable netmask)
+    int family;                 // AF_INET or AF_INET6
+    int host;                   // a /32 or /128 host, or a block merged from hosts
+    uint32_t src;               // first record covered, printed as is while it is the only one
+    uint32_t members;           // records covered
+};
+
+/**
+ * @brief qsort order of summary blocks: family, address, then shorter prefixes first.
+ */
+static int summary_cmp(const void *a, const void *b) {
+    const struct summary_block *x = a, *y = b;
+    if (x->family != y->family) return x->family == AF_INET ? -1 : 1;
+    int c = memcmp(x->net, y->net, sizeof(x->net));
+    if (c) return c;
+    return (x->len > y->len) - (x->len < y->len);
+}
+
+/**
+ * @brief Zero the bits of a network past its prefix length.
+ */
+static void summary_mask(unsigned char *net, int len) {
+    for (int i = 0; i < 16; ++i) {
+        int keep = len - 8 * i;
+        if (keep >= 8) continue;
+        net[i] &= keep > 0 ? (unsigned char)(0xff00u >> keep) : 0;
+    }
+}
+
+/**
+ * @brief Whether block `outer` contains block `inner`.
+ */
+static int summary_covers(const struct summary_block *outer, const struct summary_block *inner) {
+    if (outer->family != inner->family || outer->len > inner->len) return 0;
+    unsigned char net[16];
+    memcpy(net, inner->net, sizeof(net));
+    summary_mask(net, outer->len);
+    return memcmp(net, outer->net, sizeof(net)) == 0;
+}
+
+/**
+ * @brief Whether `lo` and `hi` are the two halves of one prefix, `lo` first.
+ */
+static int summary_siblings(const struct summary_block *lo, const struct summary_block *hi) {
+    if (lo->family != hi->family || lo->len != hi->len || lo->len == 0) return 0;
+    int bit = lo->len - 1;
+    unsigned char net[16];
+    memcpy(net, lo->net, sizeof(net));
+    if (net[bit / 8] & (0x80 >> (bit % 8))) return 0;
+    net[bit / 8] |= (unsigned char)(0x80 >> (bit % 8));
+    return memcmp(net, hi->net, sizeof(net)) == 0;
+}
+
+/**
+ * @brief Replace each interface's host addresses by the prefixes they fill (--summarize).
+ *
+ * Only hosts merge: /32 and /128 records (and records without a usable
+ * netmask). Any other record is a configured address with its on-link
+ * prefix, such as 10.0.0.5/24 or 10.0.0.8/29, and is printed unchanged,
+ * neither merged nor absorbing anything. Per interface, the hosts are
+ * sorted, then one pass keeps a stack of disjoint blocks: a host inside
+ * the top block (a duplicate, or one a merged block already covers) is
+ * absorbed, and whenever the two top blocks are the halves of one prefix
+ * they are replaced by it. A block covering a single record prints that
+ * record unchanged; merged blocks print as network/prefix. The result is
+ * IPv4 first and by address. Interfaces keep their order; the snapshot is
+ * grouped first if needed and left grouped, with its records rewritten in
+ * grouped order.
+ *
+ * @param s  Snapshot.
+ */
+void snapshot_summarize(struct snapshot *s) {
+    if (!s->order) snapshot_group(s);
+    uint32_t n = s->addr_count;
+    struct summary_block *blocks = arena_alloc(&s->arena, (n ? n : 1) * sizeof(*blocks));
+    struct summary_block *kept = arena_alloc(&s->arena, (n ? n : 1) * sizeof(*kept));
+    struct snap_addr *out = arena_alloc(&s->arena, (n ? n : 1) * sizeof(*out));
+    uint32_t written = 0;
+    for (uint32_t name = 0; name < s->name_count; ++name) {
+        struct snap_name *sn = &s->names[name];
+        for (uint32_t i = 0; i < sn->count; ++i) {
+            const struct snap_addr *r = &s->addrs[s->order[sn->first + i]];
+            struct summary_block *b = &blocks[i];
+            int width = r->family == AF_INET ? 32 : 128;
+            memcpy(b->net, r->addr, sizeof(b->net));
+            b->len = r->prefix >= 0 && r->prefix <= width ? r->prefix : width;
+            b->family = r->family;
+            b->src = s->order[sn->first + i];
+            b->members = 1;
+            b->host = b->len == width;
+        }
+        qsort(blocks, sn->count, sizeof(*blocks), summary_cmp);
+        uint32_t top = 0;  // blocks[0..top) is the stack of host blocks
+        uint32_t kept_count = 0;
+        for (uint32_t i = 0; i < sn->count; ++i) {
+            if (!blocks[i].host) {
+                kept[kept_count++] = blocks[i];
+                continue;
+            }
+            if (top && summary_covers(&blocks[top - 1], &blocks[i])) {
+                blocks[top - 1].members += blocks[i].members;
+                continue;
+            }
+            blocks[top++] = blocks[i];
+            while (top >= 2 && summary_siblings(&blocks[top - 2], &blocks[top - 1])) {
+                blocks[top - 2].len--;
+                blocks[top - 2].members += blocks[top - 1].members;
+                top--;
+            }
+        }
+        // The stack only shrinks below `i`, so the kept blocks fit after it.
+        memcpy(&blocks[top], kept, kept_count * sizeof(*kept));
+        top += kept_count;
+        if (kept_count) qsort(blocks, top, sizeof(*blocks), summary_cmp);
+        uint32_t first = written;
+        for (uint32_t i = 0; i < top; ++i) {
+            struct snap_addr *r = &out[written++];
+            *r = s->addrs[blocks[i].src];
+            if (blocks[i].members == 1) continue;
+            memcpy(r->addr, blocks[i].net, sizeof(r->addr));
+            r->prefix = (int16_t)blocks[i].len;
+        }
+        sn->first = first;
+        sn->count = top;
+    }
+    for (uint32_t i = 0; i < written; ++i) s->order[i] = i;
+    s->addrs = out;
+    s->addr_count = written;
+    s->addr_cap = n;
+}
+
+/**
+ * @brief Expand a record into the `addr_info` printers take.
+ *
+ * @param s   Snapshot.
+ * @param r   Record.
+ * @param ai  Receives the address; `ifname` points into the snapshot.
+ */
+void snapshot_addr_info(const struct snapshot *s, const struct snap_addr *r, struct addr_info *ai) {
+    ai->ifname = s->names[r->name].name;
+    ai->ifindex = r->ifindex;
+    ai->family = r->family;
+    ai->prefix = r->prefix;
+    ai->scope = r->scope;
+    memcpy(ai->addr, r->addr, sizeof(ai->addr));
+}
+
+/**
+ * @brief Release everything a snapshot holds.
+ *
+ * @param s  Snapshot (left zeroed and reusable).
+ */
+void snapshot_free(struct snapshot *s) {
+    arena_free(&s->arena);
+    memset(s, 0, sizeof(*s));
+}
+
+/**
+ * @brief Print one interface of a grouped snapshot.
+ *
+ * Grouped formats get begin / addresses / missing (if none) / end for the
+ * interface; streaming formats only the addresses.
+ *
+ * @param p       Printer.
+ * @param ifname  Interface name to print.
+ * @param s       Grouped snapshot.
+ * @param name    Name index, or SNAP_NONE when the interface is not in the snapshot.
+ */
+void print_snapshot_group(struct printer *p, const char *ifname, const struct snapshot *s, uint32_t name) {
+    uint32_t count = name != SNAP_NONE ? s->names[name].count : 0;
+    if (p->ops->grouped) p->ops->interface_begin(p, ifname); // Prints header, then all addresses of this group
+    struct addr_info ai;
+    for (uint32_t i = 0; i < count; ++i) {
+        snapshot_addr_info(s, &s->addrs[s->order[s->names[name].first + i]], &ai);
+        p->ops->address(p, ifname, &ai);
+    }
+    if (p->ops->grouped) {
+        if (!count) p->ops->missing(p, ifname);
+        p->ops->interface_end(p, ifname);
+    }
+}
+
+/**
+ * @brief Print units [lo, hi) of a snapshot: interfaces, or address records in backend order.
+ *
+ * Interfaces when the printer groups or the snapshot is seeded (see
+ * print_snapshot()), records otherwise. Only reads the snapshot, so
+ * disjoint ranges can be printed concurrently into separate buffers;
+ * interfaces need the snapshot grouped first.
+ *
+ * @param p       Printer.
+ * @param s       Filled (and for interfaces, grouped) snapshot.
+ * @param seeded  Non-zero when the names were interned before enumerating.
+ * @param lo      First unit.
+ * @param hi      One past the last unit.
+ */
+void print_snapshot_range(struct printer *p, const struct snapshot *s, int seeded, size_t lo, size_t hi) {
+    struct addr_info ai;
+    for (size_t i = lo; i < hi; ++i) {
+        if (p->ops->grouped || seeded) {
+            print_snapshot_group(p, s->names[i].name, s, (uint32_t)i);
+            continue;
+        }
+        snapshot_addr_info(s, &s->addrs[i], &ai);
+        p->ops->address(p, ai.ifname, &ai);
+    }
+}
+
+/**
+ * @brief Print every interface of a snapshot through a printer.
+ *
+ * Groups the snapshot if needed. Streaming printers just get the addresses,
+ * interface by interface. Names without addresses only exist for requested
+ * names (see show_interfaces()) and are reported through the printer's
+ * `missing` hook.
+ *
+ * @param p  Printer.
+ * @param s  Filled snapshot.
+ */
+void print_groups(struct printer *p, struct snapshot *s) {
+    if (!s->order) snapshot_group(s);
+    print_snapshot_range(p, s, 1, 0, s->name_count);
+}
+
+/**
+ * @brief Hand the link counters to a streaming printer, after its addresses.
+ *
+ * Every link, or with a seeded snapshot one per requested name. No-op for
+ * grouped printers (they print counters per interface) and without counters.
+ *
+ * @param p       Printer.
+ * @param s       Filled snapshot.
+ * @param seeded  Non-zero when the names were interned before enumerating.
+ */
+void print_snapshot_links(struct printer *p, const struct snapshot *s, int seeded) {
+    if (p->ops->grouped || !p->links) return;
+    size_t n = seeded ? s->name_count : p->links->count, count = 0;
+    const struct link_stats **links = xrealloc(NULL, (n ? n : 1) * sizeof(*links));
+    for (size_t i = 0; i < n; ++i) {
+        const struct link_stats *ls = seeded ? link_table_find(p->links, s->names[i].name) : &p->links->links[i];
+        if (link_has_fields(ls, p->links->fields)) links[count++] = ls;
+    }
+    p->ops->links(p, links, count);
+    free(links);
+}
+
+/**
+ * @brief Print a whole snapshot as one document.
+ *
+ * Grouped formats print interface by interface. Streaming formats keep the
+ * record order, unless the snapshot was seeded with requested names: then
+ * they follow the request like grouped formats do. With link counters,
+ * streaming formats end with one record per link (per requested name).
+ *
+ * @param p       Printer.
+ * @param s       Filled snapshot.
+ * @param seeded  Non-zero when the names were interned before enumerating.
+ */
+void print_snapshot(struct printer *p, struct snapshot *s, int seeded) {
+    p->ops->begin(p);
+    if (p->ops->grouped || seeded) {
+        print_groups(p, s);
+    } else {
+        print_snapshot_range(p, s, 0, 0, s->addr_count);
+    }
+    print_snapshot_links(p, s, seeded);
+    p->ops->end(p);
+}
+
+/**
+ * @brief Fill an empty snapshot from one --format=bin document.
+ *
+ * Every size, offset and field is checked before use, so any byte string is
+ * safe to hand in. Names are interned in document order, including those
+ * without records, so printing the snapshot as seeded reproduces the
+ * document that was encoded.
+ *
+ * @param s     Empty snapshot (freed by the caller on failure too).
+ * @param data  Document bytes.
+ * @param len   Number of bytes; must be exactly one document.
+ * @param f     Address filter applied to the records, or NULL.
+ * @return 0 on success; -1 (EINVAL) if `data` is not a well-formed document.
+ */
+int bin_decode(struct snapshot *s, const unsigned char *data, size_t len, const struct addr_filter *f) {
+    if (len < BIN_HEADER_SIZE || memcmp(data, BIN_MAGIC, 8) != 0 || get_le16(data + 16) != BIN_VERSION) goto bad;
+    uint64_t size = get_le64(data + 8);
+    size_t hsize = get_le16(data + 18), nsize = get_le16(data + 20), rsize = get_le16(data + 22);
+    uint32_t names = get_le32(data + 24), records = get_le32(data + 28), strings = get_le32(data + 32);
+    if (hsize < BIN_HEADER_SIZE || nsize < BIN_NAME_SIZE || rsize < BIN_RECORD_SIZE || size != len ||
+        (uint64_t)hsize + (uint64_t)names * nsize + strings + (uint64_t)records * rsize != size) goto bad;
+    const unsigned char *entry = data + hsize;
+    const char *table = (const char *)entry + (size_t)names * nsize;
+    const unsigned char *rec = (const unsigned char *)table + strings;
+    uint32_t next = 0; // records are grouped by name entry, in order
+    for (uint32_t n = 0; n < names; ++n, entry += nsize) {
+        uint32_t offset = get_le32(entry), first = get_le32(entry + 4), count = get_le32(entry + 8);
+        if (offset >= strings || !memchr(table + offset, '\0', strings - offset)) goto bad;
+        if (first != next || count > records - next) goto bad;
+        next += count;
+        uint32_t name = snapshot_intern(s, table + offset);
+        struct addr_info ai = { .ifname = table + offset, .ifindex = get_le32(entry + 12) };
+        for (uint32_t i = first; i < first + count; ++i) {
+            const unsigned char *r = rec + (size_t)i * rsize;
+            int width = r[22] == 4 ? 32 : 128;
+            ai.prefix = (int16_t)get_le16(r + 20);
+            if (get_le32(r + 16) != n || (r[22] != 4 && r[22] != 6) || r[23] > SCOPE_HOST ||
+                ai.prefix < PREFIX_NONCONTIGUOUS || ai.prefix > width) goto bad;
+            ai.family = r[22] == 4 ? AF_INET : AF_INET6;
+            ai.scope = r[23];
+            memcpy(ai.addr, r, 16);
+            if (!f || addr_filter_match(f, &ai)) snapshot_append(s, name, &ai);
+        }
+    }
+    if (next != records) goto bad;
+    return 0;
+bad:
+    errno = EINVAL;
+    return -1;
+}
+
+/**
+ * @brief Bit `i` of a big-endian key.
+ */
+static int key_bit(const unsigned char *key, int i) {
+    return (key[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+/**
+ * @brief Number of leading bits two keys share, capped at `max`.
+ */
+static int key_common_bits(const unsigned char *a, const unsigned char *b, int max) {
+    for (int i = 0; i * 8 < max; ++i) {
+        unsigned int x = a[i] ^ b[i];
+        if (x) {
+            int bits = i * 8 + clz32(x) - 24;
+            return bits < max ? bits : max;
+        }
+    }
+    return max;
+}
+
+/**
+ * @brief Append a node (capacity must already be reserved).
+ */
+static size_t trie_node_new(struct prefix_trie *t, const unsigned char *key, int len, size_t entry) {
+    struct trie_node *n = &t->nodes[t->count];
+    memset(n->key, 0, sizeof(n->key));
+    memcpy(n->key, key, (size_t)(len + 7) / 8);
+    if (len & 7) n->key[len / 8] &= (unsigned char)(0xff << (8 - (len & 7)));
+    n->len = len;
+    n->child[0] = n->child[1] = TRIE_NONE;
+    n->entry = entry;
+    return t->count++;
+}
+
+/**
+ * @brief Insert a prefix; the first owner inserted for a given prefix is kept.
+ *
+ * @param t       Trie.
+ * @param v6      0 for IPv4, 1 for IPv6.
+ * @param key     Address bytes (bits past `len` are ignored).
+ * @param len     Prefix length in bits.
+ * @param entry   Owning snapshot record.
+ */
+static void prefix_trie_insert(struct prefix_trie *t, int v6, const unsigned char *key, int len, size_t entry) {
+    if (t->count + 2 > t->cap) { // a split adds at most two nodes; links below stay valid
+        size_t cap = t->cap ? t->cap * 2 : 64;
+        t->nodes = arena_grow(t->arena, t->nodes, t->cap * sizeof(*t->nodes), cap * sizeof(*t->nodes));
+        t->cap = cap;
+    }
+    size_t *link = &t->root[v6];
+    for (;;) {
+        if (*link == TRIE_NONE) {
+            *link = trie_node_new(t, key, len, entry);
+            return;
+        }
+        struct trie_node *n = &t->nodes[*link];
+        int common = key_common_bits(n->key, key, n->len < len ? n->len : len);
+        if (common == n->len) {
+            if (len == n->len) { // same prefix: fill a split point, keep an earlier owner
+                if (n->entry == TRIE_NONE) n->entry = entry;
+                return;
+            }
+            link = &n->child[key_bit(key, n->len)];
+            continue;
+        }
+        // Diverges inside this node's path: split it at `common`.
+        size_t below = *link;
+        size_t mid = trie_node_new(t, key, common, TRIE_NONE);
+        t->nodes[mid].child[key_bit(t->nodes[below].key, common)] = below;
+        if (common == len) {
+            t->nodes[mid].entry = entry;
+        } else {
+            t->nodes[mid].child[key_bit(key, common)] = trie_node_new(t, key, len, entry);
+        }
+        *link = mid;
+        return;
+    }
+}
+
+/**
+ * @brief Find the most specific prefix containing an address.
+ *
+ * @param t    Trie.
+ * @param v6   0 for IPv4, 1 for IPv6.
+ * @param key  Address bytes.
+ * @return Matching node, or NULL if no prefix contains the address.
+ */
+const struct trie_node *prefix_trie_lookup(const struct prefix_trie *t, int v6, const unsigned char *key) {
+    int bits = v6 ? 128 : 32;
+    const struct trie_node *best = NULL;
+    for (size_t i = t->root[v6]; i != TRIE_NONE;) {
+        const struct trie_node *n = &t->nodes[i];
+        if (key_common_bits(n->key, key, n->len) < n->len) break; // off this path
+        if (n->entry != TRIE_NONE) best = n;
+        if (n->len == bits) break;
+        i = n->child[key_bit(key, n->len)];
+    }
+    return best;
+}
+
+/**
+ * @brief Index every address of a snapshot (addresses and their networks).
+ *
+ * Records are inserted interface by interface (first-seen order), so on equal
+ * prefixes the first interface listed by `ifshow -a` wins.
+ *
+ * @param t     Trie to fill (zeroed).
+ * @param snap  Snapshot to index; the nodes are allocated from its arena.
+ */
+void prefix_trie_build(struct prefix_trie *t, struct snapshot *snap) {
+    t->arena = &snap->arena;
+    t->root[0] = t->root[1] = TRIE_NONE;
+    if (!snap->order) snapshot_group(snap);
+    for (uint32_t i = 0; i < snap->addr_count; ++i) {
+        const struct snap_addr *r = &snap->addrs[snap->order[i]];
+        int v6 = r->family == AF_INET6, bits = v6 ? 128 : 32;
+        prefix_trie_insert(t, v6, r->addr, bits, snap->order[i]);
+        if (r->prefix >= 0 && r->prefix < bits) prefix_trie_insert(t, v6, r->addr, r->prefix, snap->order[i]);
+    }
+}
+
+/* Public API (ifshow.h). */
+
+// The public types are views of the internal ones, handed out without copying.
+_Static_assert(sizeof(struct ifshow_addr) == sizeof(struct addr_info) &&
+               offsetof(struct ifshow_addr, ifname) == offsetof(struct addr_info, ifname) &&
+               offsetof(struct ifshow_addr, ifindex) == offsetof(struct addr_info, ifindex) &&
+               offsetof(struct ifshow_addr, family) == offsetof(struct addr_info, family) &&
+               offsetof(struct ifshow_addr, prefix) == offsetof(struct addr_info, prefix) &&
+               offsetof(struct ifshow_addr, scope) == offsetof(struct addr_info, scope) &&
+               offsetof(struct ifshow_addr, addr) == offsetof(struct addr_info, addr), "ifshow_addr layout");
+_Static_assert((int)IFSHOW_SCOPE_HOST == SCOPE_HOST && (int)IFSHOW_SCOPE_LINK == SCOPE_LINK &&
+               (int)IFSHOW_SCOPE_SITE == SCOPE_SITE && (int)IFSHOW_SCOPE_GLOBAL == SCOPE_GLOBAL, "ifshow_scope values");
+_Static_assert((int)IFSHOW_SORT_INDEX == SORT_INDEX && (int)IFSHOW_SORT_NAME == SORT_NAME &&
+               (int)IFSHOW_SORT_ADDR == SORT_ADDR && (int)IFSHOW_SORT_NONE == SORT_NONE, "ifshow_sort values");
+_Static_assert(sizeof(((struct ifshow_link *)0)->hwaddr) == LINK_HWADDR_MAX, "ifshow_link hardware address size");
+_Static_assert((int)IFSHOW_FORMAT_TEXT == FORMAT_TEXT && (int)IFSHOW_FORMAT_JSON == FORMAT_JSON &&
+               (int)IFSHOW_FORMAT_NDJSON == FORMAT_NDJSON && (int)IFSHOW_FORMAT_OPENMETRICS == FORMAT_OPENMETRICS &&
+               (int)IFSHOW_FORMAT_BIN == FORMAT_BIN, "ifshow_format values");
+
+struct ifshow_ctx {
+    enum backend backend;
+#ifdef __linux__
+    struct nl_sock nl;      // opened on first use, then shared by every dump
+    int nl_ready;
+#endif
+};
+
+struct ifshow_filter {
+    struct addr_filter f;
+};
+
+struct ifshow_snapshot {
+    struct snapshot snap;       // grouped on creation
+    struct link_table links;    // IFSHOW_STATS counters
+    int has_links;
+    int seeded;                 // taken for requested names
+    struct prefix_trie trie;    // ifshow_snapshot_owner() index, built on first use
+    int trie_ready;
+};
+
+struct ifshow_ctx *ifshow_open(enum ifshow_backend backend) {
+    struct ifshow_ctx *ctx;
+    switch (backend) {
+        case IFSHOW_BACKEND_DEFAULT:
+        case IFSHOW_BACKEND_GETIFADDRS:
+            break;
+        case IFSHOW_BACKEND_NETLINK:
+#ifndef __linux__
+            errno = ENOTSUP;
+            return NULL;
+#endif
+            break;
+        case IFSHOW_BACKEND_SYSCTL:
+#ifndef HAVE_RT_IFLIST
+            errno = ENOTSUP;
+            return NULL;
+#endif
+            break;
+        default:
+            errno = EINVAL;
+            return NULL;
+    }
+    ctx = xrealloc(NULL, sizeof(*ctx));
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->backend = backend == IFSHOW_BACKEND_DEFAULT ? BACKEND_DEFAULT :
+                   backend == IFSHOW_BACKEND_NETLINK ? BACKEND_NETLINK :
+                   backend == IFSHOW_BACKEND_SYSCTL ? BACKEND_SYSCTL : BACKEND_GETIFADDRS;
+    return ctx;
+}
+
+void ifshow_close(struct ifshow_ctx *ctx) {
+    if (!ctx) return;
+#ifdef __linux__
+    if (ctx->nl_ready) nl_close(&ctx->nl);
+#endif
+    free(ctx);
+}
+
+/**
+ * @brief The context's netlink socket, opened on first use.
+ *
+ * @param ctx  Context.
+ * @param nl   Receives the socket (NULL for getifaddrs).
+ * @return 0 on success; -1 if the socket cannot be opened (errno set).
+ */
+static int ctx_socket(struct ifshow_ctx *ctx, struct nl_sock **nl) {
+    *nl = NULL;
+#ifdef __linux__
+    if (ctx->backend != BACKEND_NETLINK) return 0;
+    if (!ctx->nl_ready) {
+        if (nl_open(&ctx->nl) != 0) return -1;
+        ctx->nl_ready = 1;
+    }
+    *nl = &ctx->nl;
+#else
+    (void)ctx;
+#endif
+    return 0;
+}
+
+struct ifshow_filter *ifshow_filter_new(void) {
+    struct ifshow_filter *f = xrealloc(NULL, sizeof(*f));
+    memset(f, 0, sizeof(*f));
+    return f;
+}
+
+int ifshow_filter_family(struct ifshow_filter *f, int family) {
+    if (family != AF_INET && family != AF_INET6) {
+        errno = EINVAL;
+        return -1;
+    }
+    f->f.families |= family == AF_INET ? FILTER_INET : FILTER_INET6;
+    if (f->f.families == (FILTER_INET | FILTER_INET6)) f->f.families = 0; // both: no constraint
+    return 0;
+}
+
+int ifshow_filter_scopes(struct ifshow_filter *f, const char *scopes) {
+    unsigned int bits = addr_filter_parse_scopes(scopes);
+    if (!bits) {
+        errno = EINVAL;
+        return -1;
+    }
+    f->f.scopes |= bits;
+    return 0;
+}
+
+int ifshow_filter_network(struct ifshow_filter *f, const char *cidr) {
+    if (addr_filter_add_net(&f->f, cidr) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void ifshow_filter_free(struct ifshow_filter *f) {
+    if (!f) return;
+    free(f->f.nets);
+    free(f);
+}
+
+struct ifshow_snapshot *ifshow_snapshot_take(struct ifshow_ctx *ctx, const struct ifshow_request *req) {
+    static const struct ifshow_request everything;
+    static const struct addr_filter no_filter;
+    if (!req) req = &everything;
+    struct nl_sock *nl;
+    if (ctx_socket(ctx, &nl) != 0) return NULL;
+    struct ifshow_snapshot *s = xrealloc(NULL, sizeof(*s));
+    memset(s, 0, sizeof(*s));
+    if (req->flags & (IFSHOW_STATS | IFSHOW_LINK)) {
+        int rc = (req->flags & IFSHOW_STATS) || ctx->backend == BACKEND_NETLINK ? link_table_load_on(nl, &s->links)
+                                                                                 : link_table_ifaddrs(&s->links);
+        if (rc != 0) goto fail;
+        s->links.fields = (req->flags & IFSHOW_STATS ? LINK_COUNTERS : 0) | (req->flags & IFSHOW_LINK ? LINK_LAYER : 0);
+        s->has_links = 1;
+    }
+    s->seeded = req->name_count > 0;
+    for (size_t i = 0; i < req->name_count; ++i) snapshot_intern(&s->snap, req->names[i]);
+    const struct addr_filter *filter = req->filter ? &req->filter->f : &no_filter;
+    if (enumerate_with(ctx->backend, nl, filter, NULL, s->seeded ? snapshot_add_known : snapshot_add, &s->snap, NULL) != 0) goto fail;
+    if (s->has_links && !s->seeded) snapshot_add_links(&s->snap, &s->links);
+    snapshot_sort(&s->snap, (enum sort_order)req->sort);
+    snapshot_group(&s->snap);
+    if (req->flags & IFSHOW_SUMMARIZE) snapshot_summarize(&s->snap);
+    return s;
+fail:;
+    int saved = errno;
+    ifshow_snapshot_free(s);
+    errno = saved;
+    return NULL;
+}
+
+struct ifshow_snapshot *ifshow_snapshot_decode(const void *data, size_t len) {
+    struct ifshow_snapshot *s = xrealloc(NULL, sizeof(*s));
+    memset(s, 0, sizeof(*s));
+    s->seeded = 1; // keep the document's interfaces and order
+    if (bin_decode(&s->snap, data, len, NULL) != 0) {
+        ifshow_snapshot_free(s);
+        errno = EINVAL;
+        return NULL;
+    }
+    snapshot_group(&s->snap);
+    return s;
+}
+
+size_t ifshow_snapshot_interface_count(const struct ifshow_snapshot *s) {
+    return s->snap.name_count;
+}
+
+const char *ifshow_snapshot_interface(const struct ifshow_snapshot *s, size_t i) {
+    return i < s->snap.name_count ? s->snap.names[i].name : NULL;
+}
+
+size_t ifshow_snapshot_foreach(const struct ifshow_snapshot *s, const char *ifname, ifshow_addr_fn fn, void *arg) {
+    const struct snapshot *snap = &s->snap;
+    uint32_t first = 0, last = snap->name_count;
+    if (ifname) {
+        first = snapshot_find(snap, ifname);
+        if (first == SNAP_NONE) return 0;
+        last = first + 1;
+    }
+    size_t visited = 0;
+    struct addr_info ai;
+    for (uint32_t n = first; n < last; ++n) {
+        for (uint32_t i = 0; i < snap->names[n].count; ++i) {
+            snapshot_addr_info(snap, &snap->addrs[snap->order[snap->names[n].first + i]], &ai);
+            visited++;
+            if (fn((const struct ifshow_addr *)&ai, arg)) return visited;
+        }
+    }
+    return visited;
+}
+
+int ifshow_snapshot_stats(const struct ifshow_snapshot *s, const char *ifname, struct ifshow_link_stats *stats) {
+    const struct link_stats *ls = s->has_links ? link_table_find(&s->links, ifname) : NULL;
+    if (!ls || !ls->counters) {
+        errno = ENOENT;
+        return -1;
+    }
+    stats->rx_bytes = ls->rx_bytes;
+    stats->rx_packets = ls->rx_packets;
+    stats->rx_errors = ls->rx_errors;
+    stats->rx_dropped = ls->rx_dropped;
+    stats->tx_bytes = ls->tx_bytes;
+    stats->tx_packets = ls->tx_packets;
+    stats->tx_errors = ls->tx_errors;
+    stats->tx_dropped = ls->tx_dropped;
+    return 0;
+}
+
+int ifshow_snapshot_link(const struct ifshow_snapshot *s, const char *ifname, struct ifshow_link *link) {
+    const struct link_stats *ls = s->has_links && (s->links.fields & LINK_LAYER) ? link_table_find(&s->links, ifname) : NULL;
+    if (!ls) {
+        errno = ENOENT;
+        return -1;
+    }
+    link->flags = ls->flags;
+    link->mtu = ls->mtu;
+    link->hwlen = ls->hwlen;
+    memcpy(link->hwaddr, ls->hwaddr, sizeof(link->hwaddr));
+    return 0;
+}
+
+int ifshow_snapshot_owner(struct ifshow_snapshot *s, const char *address, struct ifshow_addr *owner) {
+    unsigned char key[16];
+    int v6 = strchr(address, ':') != NULL;
+    if (inet_pton(v6 ? AF_INET6 : AF_INET, address, key) != 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!s->trie_ready) {
+        prefix_trie_build(&s->trie, &s->snap);
+        s->trie_ready = 1;
+    }
+    const struct trie_node *n = prefix_trie_lookup(&s->trie, v6, key);
+    if (!n) return 0;
+    snapshot_addr_info(&s->snap, &s->snap.addrs[n->entry], (struct addr_info *)owner);
+    return 1;
+}
+
+int ifshow_snapshot_format(struct ifshow_snapshot *s, enum ifshow_format format, ifshow_write_fn write, void *arg) {
+    if (format != IFSHOW_FORMAT_TEXT && format != IFSHOW_FORMAT_JSON && format != IFSHOW_FORMAT_NDJSON
+        && format != IFSHOW_FORMAT_OPENMETRICS && format != IFSHOW_FORMAT_BIN) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct outbuf ob = { .fd = -1, .sink = write, .sink_arg = arg };
+    struct printer p = { .ops = printer_ops_for((enum output_format)format), .ob = &ob };
+    if (s->has_links) p.links = &s->links;
+    print_snapshot(&p, &s->snap, s->seeded);
+    int rc = out_flush(&ob);
+    free(ob.data);
+    return rc;
+}
+
+void ifshow_snapshot_free(struct ifshow_snapshot *s) {
+    if (!s) return;
+    snapshot_free(&s->snap); // trie nodes included
+    free(s->links.links);
+    free(s);
+}
@@ -0,0 +1,447 @@
+/*
+ * libifshow_internal.h - libifshow internals shared with the ifshow CLI and the tests.
+ * FR: libifshow_internal.h - Fonctions internes de libifshow partagées avec la CLI ifshow et les tests.
+ *
+ * Not installed: embedders use ifshow.h, whose ifshow_* functions are the
+ * only symbols the release archive exports. Everything declared here is
+ * defined in libifshow.c and documented there.
+ */
+
+#ifndef LIBIFSHOW_INTERNAL_H
+#define LIBIFSHOW_INTERNAL_H
+
+#include "ifshow.h"
+
+#include <net/if.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <netpacket/packet.h>
+#ifndef IFF_LOWER_UP
+#define IFF_LOWER_UP 0x10000 // <linux/if.h>, which conflicts with <net/if.h>
+#endif
+#endif
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define HAVE_RT_IFLIST // routing-socket sysctl(NET_RT_IFLIST)
+#include <sys/sysctl.h>
+#include <net/if_dl.h>
+#include <net/route.h>
+#endif
+
+/**
+ * @brief Address enumeration backends.
+ */
+enum backend {
+    BACKEND_GETIFADDRS, // portable libc getifaddrs()
+    BACKEND_NETLINK,    // Linux rtnetlink RTM_GETADDR dump
+    BACKEND_SYSCTL,     // BSD/macOS sysctl(NET_RT_IFLIST) routing messages
+};
+
+#if defined(__linux__)
+#define BACKEND_DEFAULT BACKEND_NETLINK
+#elif defined(HAVE_RT_IFLIST)
+#define BACKEND_DEFAULT BACKEND_SYSCTL
+#else
+#define BACKEND_DEFAULT BACKEND_GETIFADDRS
+#endif
+
+/**
+ * @brief Address scope, ordered from widest to narrowest.
+ */
+enum addr_scope {
+    SCOPE_GLOBAL,   // routable (RT_SCOPE_UNIVERSE)
+    SCOPE_SITE,     // IPv6 site-local (deprecated fec0::/10)
+    SCOPE_LINK,     // link-local (169.254/16, fe80::/10)
+    SCOPE_HOST,     // loopback
+};
+
+/**
+ * @brief One IP address as delivered by an enumeration backend.
+ *
+ * Fields are only valid for the duration of the visitor callback; the
+ * `ifname` storage in particular belongs to the backend.
+ */
+struct addr_info {
+    const char *ifname;         // interface name (IPv4 label when one is set)
+    unsigned int ifindex;       // kernel interface index, 0 if the backend does not know it
+    int family;                 // AF_INET or AF_INET6
+    int prefix;                 // prefix length, -1 when no netmask is known, PREFIX_NONCONTIGUOUS
+    int scope;                  // enum addr_scope
+    unsigned char addr[16];     // address bytes in network order (first 4 used for IPv4)
+};
+
+/**
+ * @brief Visitor called once per address; a non-zero return stops the enumeration.
+ */
+typedef int (*addr_visit_fn)(const struct addr_info *ai, void *ctx);
+
+#define PREFIX_NONCONTIGUOUS (-2) // netmask whose 1-bits are not a single leading run
+
+/**
+ * @brief Growable output buffer, written out with as few `write` calls as possible.
+ *
+ * A buffer with `fd >= 0` (or a `sink`) is flushed to it once it passes
+ * OUT_FLUSH_THRESHOLD and when the output is complete; with `fd < 0` and no
+ * sink it only accumulates in memory.
+ */
+struct outbuf {
+    char *data;
+    size_t len, cap;
+    int fd;
+    ifshow_write_fn sink;   // library callers' writer, used instead of `fd` when set
+    void *sink_arg;
+    int failed;             // the sink failed: later output is dropped
+};
+
+#define FILTER_INET  1u // -4
+#define FILTER_INET6 2u // -6
+
+/**
+ * @brief One `--in` network, pre-masked for a word-wise containment test.
+ */
+struct filter_net {
+    int family;
+    uint32_t net[4];    // network bits, network byte order (first word only for IPv4)
+    uint32_t mask[4];
+};
+
+/**
+ * @brief Address predicate compiled from -4/-6/--scope/--in.
+ *
+ * Every test works on the raw `addr_info`, so filtered-out addresses are
+ * dropped before any formatting happens. Empty criteria accept everything.
+ */
+struct addr_filter {
+    unsigned int families;      // FILTER_INET / FILTER_INET6 bits, 0 for both
+    unsigned int scopes;        // 1 << SCOPE_* bits, 0 for any
+    struct filter_net *nets;    // address must be inside one of them, none: no constraint
+    size_t net_count, net_cap;
+};
+
+/**
+ * @brief One compiled element of an interface-name pattern.
+ */
+struct glob_token {
+    int star;                   // '*': any run of characters (`set` unused)
+    unsigned char set[32];      // otherwise: bitmap of the bytes this position accepts
+};
+
+/**
+ * @brief An interface-name glob (`*`, `?`, `[a-z]`, `[!0-3]`, `\` escapes), compiled once.
+ *
+ * The leading literal characters are kept as a plain prefix compared with
+ * memcmp() before any token is looked at, so most names are rejected on
+ * their first bytes.
+ */
+struct name_glob {
+    const char *text;           // pattern as given
+    char *prefix;               // literal prefix, NUL-terminated
+    size_t prefix_len;
+    struct glob_token *tokens;  // what follows the prefix
+    size_t token_count;
+    int matched;                // some enumerated name matched it
+};
+
+#define LINK_HWADDR_MAX 32 // longest hardware address kept (InfiniBand uses 20 bytes)
+
+/**
+ * @brief Counters (IFLA_STATS64) and link-layer state of one link.
+ */
+struct link_stats {
+    unsigned int ifindex;
+    char name[IF_NAMESIZE];
+    uint64_t rx_bytes, rx_packets, rx_errors, rx_dropped;
+    uint64_t tx_bytes, tx_packets, tx_errors, tx_dropped;
+    int counters;               // the counters above were reported
+    unsigned int flags;         // IFF_* (IFF_LOWER_UP included on Linux)
+    unsigned int mtu;           // 0 if unknown
+    unsigned char hwaddr[LINK_HWADDR_MAX];
+    size_t hwlen;               // 0 for links without a hardware address
+};
+
+#define LINK_COUNTERS 0x1u  // link_table.fields: print the counters (--stats)
+#define LINK_LAYER 0x2u     // link_table.fields: print flags, MTU and hardware address (-l)
+
+/**
+ * @brief Every link from one RTM_GETLINK dump (or getifaddrs call), sorted by name.
+ */
+struct link_table {
+    struct link_stats *links;
+    size_t count, cap;
+    unsigned int fields;    // LINK_COUNTERS and/or LINK_LAYER: what printers show of each link
+};
+
+struct nl_sock; // rtnetlink socket (Linux only), passed around as an opaque pointer elsewhere
+
+#ifdef __linux__
+
+#define NL_BUFSIZE 32768            // the kernel never builds dump chunks larger than this
+
+/**
+ * @brief An rtnetlink socket with its receive buffer.
+ */
+struct nl_sock {
+    int fd;
+    uint32_t seq;           // sequence number of the last request sent
+    unsigned char *buf;     // NL_BUFSIZE bytes, reused for every recv
+};
+
+/**
+ * @brief State shared by the RTM_NEWADDR handler across one dump.
+ */
+struct nl_addr_walk {
+    struct nl_sock *nl;
+    addr_visit_fn visit;
+    void *ctx;
+    unsigned int ifindex;       // only this interface (0 = all); also checked here for pre-4.20 kernels
+    const char *ifname;         // only entries with this name (labels may differ within one ifindex), or NULL
+    unsigned int name_index;    // ifindex whose name is cached in `name`, 0 if none
+    char name[IF_NAMESIZE];
+};
+
+#endif /* __linux__ */
+
+/**
+ * @brief Output formats (values match enum ifshow_format).
+ */
+enum output_format {
+    FORMAT_TEXT,    // grouped, human-readable bullets
+    FORMAT_JSON,    // one JSON document
+    FORMAT_NDJSON,  // one JSON record per address, streamed
+    FORMAT_OPENMETRICS, // Prometheus/OpenMetrics text exposition, streamed
+    FORMAT_BIN,     // length-prefixed binary document (string table + fixed-size records)
+};
+
+struct printer;
+struct bin_doc;
+
+/**
+ * @brief Callbacks implementing one output format.
+ *
+ * Grouped formats receive interface_begin / address... / interface_end per
+ * interface; streaming formats only receive address calls, in backend order,
+ * then a single `links` call when link counters were loaded.
+ * `event` may be NULL when the format cannot describe watch-mode changes.
+ */
+struct printer_ops {
+    int grouped;    // needs addresses grouped per interface before output
+    void (*begin)(struct printer *p);
+    void (*interface_begin)(struct printer *p, const char *ifname);
+    void (*address)(struct printer *p, const char *ifname, const struct addr_info *ai);
+    void (*missing)(struct printer *p, const char *ifname);
+    void (*interface_end)(struct printer *p, const char *ifname);
+    void (*end)(struct printer *p);
+    void (*event)(struct printer *p, char sign, const struct addr_info *ai);
+    void (*links)(struct printer *p, const struct link_stats *const *links, size_t count); // streaming only
+};
+
+/**
+ * @brief An output format bound to a buffer, with its per-document state.
+ */
+struct printer {
+    const struct printer_ops *ops;
+    struct outbuf *ob;
+    const char *netns;  // namespace being printed by --all-netns, or NULL
+    const struct link_table *links; // --stats counters to print per interface, or NULL
+    int single;         // output for -i: text ends without the blank separator line
+    size_t ifaces;      // JSON: interfaces written so far (comma placement)
+    size_t addrs;       // JSON: addresses written in the current interface
+    struct bin_doc *bin; // --format=bin: document assembled until `end`
+};
+
+/**
+ * @brief One block of an arena; allocations are carved from `data` front to back.
+ */
+struct arena_block {
+    struct arena_block *next;
+    size_t used, cap;
+    max_align_t data[];
+};
+
+/**
+ * @brief Bump allocator: many small allocations, one release.
+ */
+struct arena {
+    struct arena_block *head;   // block currently carved from
+};
+
+#define SNAP_NONE ((uint32_t)-1) // no such name
+
+/**
+ * @brief One address of a snapshot, compact and self-contained.
+ */
+struct snap_addr {
+    unsigned char addr[16];     // network order, first 4 bytes for IPv4
+    uint32_t ifindex;
+    uint32_t name;              // index into the snapshot's names
+    int16_t prefix;             // as in `struct addr_info`
+    uint8_t family;             // AF_INET or AF_INET6
+    uint8_t scope;              // enum addr_scope
+};
+
+/**
+ * @brief One interned interface name and its addresses once grouped.
+ */
+struct snap_name {
+    const char *name;           // NUL-terminated, in the arena
+    uint32_t hash;              // hash_name(name), kept for rehashing
+    uint32_t count;             // addresses carrying this name
+    uint32_t first;             // start of its run in `order` (valid after snapshot_group())
+};
+
+/**
+ * @brief Every address of one enumeration, allocated from a single arena.
+ *
+ * Names are interned once (open-addressing hash), addresses are one
+ * contiguous array in backend order, and snapshot_group() adds an index array
+ * listing them interface by interface, names in first-seen order.
+ * snapshot_free() releases it all at once.
+ */
+struct snapshot {
+    struct arena arena;
+    struct snap_name *names;
+    uint32_t name_count, name_cap;
+    struct snap_addr *addrs;
+    uint32_t addr_count, addr_cap;
+    uint32_t *slots;            // name index + 1 per slot, 0 when empty
+    uint32_t slot_mask;         // slot count - 1 (slot count is a power of two)
+    uint32_t *order;            // address indices grouped by name, NULL until snapshot_group()
+};
+
+/**
+ * @brief Address counts of one interface, for --count.
+ */
+struct count_entry {
+    uint32_t name;          // index in the name table, also the first-seen (or requested) order
+    unsigned int ifindex;   // kernel interface index, 0 until known
+    size_t inet, inet6;
+};
+
+/**
+ * @brief What --count and --exists gather: interned names and a counter per name, no address.
+ */
+struct count_table {
+    struct snapshot names;          // only the name table is used
+    struct count_entry *entries;    // indexed like `names.names`
+    size_t cap;
+    int known_only;                 // -i: addresses of other interfaces are ignored
+    size_t missing;                 // --exists: requested names without an address yet
+};
+
+/**
+ * @brief Snapshot orders (values match enum ifshow_sort).
+ */
+enum sort_order {
+    SORT_NONE,      // backend order, interfaces first-seen
+    SORT_INDEX,     // by ifindex (aliases by name), then address
+    SORT_NAME,      // by interface name, then address
+    SORT_ADDR,      // by address; interfaces follow their lowest address
+};
+
+#define TRIE_NONE ((size_t)-1) // no child / no owner
+
+/**
+ * @brief One node of a path-compressed binary trie over address prefixes.
+ */
+struct trie_node {
+    unsigned char key[16];  // prefix bits, zero past `len`
+    int len;                // prefix length in bits
+    size_t child[2];        // next node by the bit at `len`, TRIE_NONE when absent
+    size_t entry;           // owning address (snapshot record), TRIE_NONE for split points
+};
+
+/**
+ * @brief Longest-prefix index from addresses to their interfaces.
+ *
+ * Nodes live in one growable array in the snapshot's arena and link by
+ * index, one root per family.
+ * Each local address is inserted twice: as a full-length key (the address
+ * itself) and as its network, so a query for a local address finds the
+ * interface carrying it and any other query the most specific network.
+ */
+struct prefix_trie {
+    struct arena *arena;    // the indexed snapshot's arena, released with it
+    struct trie_node *nodes;
+    size_t count, cap;
+    size_t root[2];         // [0] IPv4, [1] IPv6
+};
+
+// Helpers and output buffers.
+size_t fmt_ipv4(char *dst, const unsigned char *a);
+size_t fmt_ipv6(char *dst, const unsigned char *a);
+int addr_to_string(int family, const void *addr, char *buf, size_t buflen);
+int count_prefix_length(const struct sockaddr *netmask);
+void *xrealloc(void *ptr, size_t size);
+int out_flush(struct outbuf *ob);
+char *out_reserve(struct outbuf *ob, size_t n);
+void out_write(struct outbuf *ob, const void *data, size_t n);
+void out_puts(struct outbuf *ob, const char *s);
+void out_vprintf(struct outbuf *ob, const char *fmt, va_list ap);
+void out_printf(struct outbuf *ob, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Scopes and filters.
+int addr_scope_of(int family, const unsigned char *addr);
+int addr_filter_active(const struct addr_filter *f);
+int addr_filter_match(const struct addr_filter *f, const struct addr_info *ai);
+unsigned int addr_filter_parse_scopes(const char *list);
+int addr_filter_add_net(struct addr_filter *f, const char *cidr);
+
+// Interface-name globs.
+int name_is_glob(const char *name);
+void name_glob_compile(struct name_glob *g, const char *text);
+int name_glob_match(const struct name_glob *g, const char *name);
+void name_glob_free(struct name_glob *g);
+
+// Backends and link tables.
+const struct link_stats *link_table_find(const struct link_table *t, const char *name);
+int link_table_ifaddrs(struct link_table *t);
+int link_table_load_on(struct nl_sock *nl, struct link_table *t);
+int enumerate_with(enum backend which, struct nl_sock *nl, const struct addr_filter *filter, const char *ifname,
+                   addr_visit_fn visit, void *ctx, size_t *seen);
+#ifdef __linux__
+int nl_open(struct nl_sock *nl);
+void nl_close(struct nl_sock *nl);
+int nl_parse_addr(struct nl_addr_walk *w, const struct nlmsghdr *nlh, struct addr_info *ai);
+#endif
+
+// Printers.
+int format_address(struct outbuf *ob, const struct addr_info *ai);
+void print_address_bullet(struct outbuf *ob, const struct addr_info *ai);
+void json_string(struct outbuf *ob, const char *s);
+void json_address_members(struct outbuf *ob, const struct addr_info *ai);
+void openmetrics_label(struct outbuf *ob, const char *s);
+const struct printer_ops *printer_ops_for(enum output_format format);
+
+// Snapshots.
+void *arena_alloc(struct arena *a, size_t size);
+uint32_t snapshot_find(const struct snapshot *s, const char *name);
+uint32_t snapshot_intern(struct snapshot *s, const char *name);
+void snapshot_append(struct snapshot *s, uint32_t name, const struct addr_info *ai);
+int snapshot_add(const struct addr_info *ai, void *ctx);
+int snapshot_add_known(const struct addr_info *ai, void *ctx);
+void snapshot_add_links(struct snapshot *s, const struct link_table *t);
+int count_visit(const struct addr_info *ai, void *ctx);
+void count_table_seed(struct count_table *t, const char *const *names, size_t count, int stop_when_found);
+void snapshot_group(struct snapshot *s);
+void snapshot_sort(struct snapshot *s, enum sort_order order);
+void snapshot_summarize(struct snapshot *s);
+void snapshot_addr_info(const struct snapshot *s, const struct snap_addr *r, struct addr_info *ai);
+void snapshot_free(struct snapshot *s);
+void print_snapshot_group(struct printer *p, const char *ifname, const struct snapshot *s, uint32_t name);
+void print_snapshot_range(struct printer *p, const struct snapshot *s, int seeded, size_t lo, size_t hi);
+void print_groups(struct printer *p, struct snapshot *s);
+void print_snapshot_links(struct printer *p, const struct snapshot *s, int seeded);
+void print_snapshot(struct printer *p, struct snapshot *s, int seeded);
+int bin_decode(struct snapshot *s, const unsigned char *data, size_t len, const struct addr_filter *f);
+
+// Owner lookups.
+const struct trie_node *prefix_trie_lookup(const struct prefix_trie *t, int v6, const unsigned char *key);
+void prefix_trie_build(struct prefix_trie *t, struct snapshot *snap);
+
+#endif /* LIBIFSHOW_INTERNAL_H */
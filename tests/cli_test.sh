@@ -0,0 +1,157 @@
+#!/bin/sh
+#
+# cli_test.sh - End-to-end checks of the ifshow command line.
+# FR: cli_test.sh - Vérifications de bout en bout de la ligne de commande ifshow.
+#
+# Usage / Utilisation:
+# - sh tests/cli_test.sh [<ifshow>]. EN: Run the checks against that binary (default ./ifshow); exits 1 on failure.
+#   FR: Lance les vérifications sur ce binaire (./ifshow par défaut) ; sort avec 1 en cas d'échec.
+#
+# Checks needing controlled addresses run in a throwaway network namespace
+# and are skipped when `ip netns` is not available (not root, not Linux).
+
+IFSHOW=${1:-./ifshow}
+TMP=$(mktemp -d) || exit 1
+NETNS=ifshow-test-$$
+failures=0
+
+cleanup() {
+    rm -rf "$TMP"
+    ip netns del "$NETNS" 2>/dev/null
+}
+trap cleanup EXIT
+
+# fail <what>: report one failed check.
+fail() {
+    echo "  check failed: $1" >&2
+    failures=$((failures + 1))
+}
+
+# report <name> <failures before>: one ok/FAIL line per test, like tests/ifshow_test.
+report() {
+    if [ "$failures" -eq "$2" ]; then echo "ok   $1"; else echo "FAIL $1"; fi
+}
+
+# in_netns <command...>: run in the test namespace.
+in_netns() {
+    ip netns exec "$NETNS" "$@"
+}
+
+have_netns() {
+    [ "$(id -u)" -eq 0 ] && command -v ip >/dev/null 2>&1 && ip netns add "$NETNS" 2>/dev/null
+}
+
+test_bin_round_trip() {
+    before=$failures
+    "$IFSHOW" -a --format=bin > "$TMP/doc" || fail "--format=bin exits 0"
+    for format in text json; do
+        "$IFSHOW" -a --format=$format > "$TMP/want" 2>&1
+        "$IFSHOW" --read "$TMP/doc" --format=$format > "$TMP/got" 2>&1 || fail "--read --format=$format exits 0"
+        cmp -s "$TMP/want" "$TMP/got" || fail "--read --format=$format prints what -a prints"
+    done
+    "$IFSHOW" -a --format=text > "$TMP/want" 2>&1
+    cat "$TMP/doc" | "$IFSHOW" --read /dev/stdin > "$TMP/got" 2>&1 || fail "--read /dev/stdin from a pipe exits 0"
+    cmp -s "$TMP/want" "$TMP/got" || fail "--read /dev/stdin from a pipe prints what -a prints"
+    head -c 20 "$TMP/doc" > "$TMP/short"
+    "$IFSHOW" --read "$TMP/short" > /dev/null 2>&1 && fail "--read rejects a truncated document"
+    "$IFSHOW" --read "$TMP" 2>&1 | grep -q 'Is a directory' || fail "--read of a directory reports it as such"
+    "$IFSHOW" --read "$TMP/missing" 2>&1 | grep -q 'No such file' || fail "--read of a missing file reports it as such"
+    report bin_round_trip "$before"
+}
+
+test_save_diff() {
+    before=$failures
+    "$IFSHOW" --save "$TMP/state" || fail "--save exits 0"
+    out=$("$IFSHOW" --diff "$TMP/state") || fail "--diff exits 0"
+    [ -z "$out" ] || fail "--diff right after --save prints nothing"
+    printf 'not a state file' > "$TMP/junk"
+    "$IFSHOW" --diff "$TMP/junk" > /dev/null 2>&1 && fail "--diff rejects a foreign file"
+    report save_diff "$before"
+}
+
+# parses <json|ndjson> <file>: whether the file is one JSON document, or one per line.
+parses() {
+    python3 -c '
+import json, sys
+with open(sys.argv[2]) as f:
+    if sys.argv[1] == "json":
+        json.load(f)
+    else:
+        for line in f:
+            json.loads(line)
+' "$1" "$2"
+}
+
+test_json_details() {
+    before=$failures
+    for format in json ndjson; do
+        for details in "" "-l" "--stats" "-l --stats"; do
+            # shellcheck disable=SC2086 # $details holds zero, one or two options
+            "$IFSHOW" --$format -a $details > "$TMP/out" || fail "--$format -a $details exits 0"
+            parses $format "$TMP/out" || fail "--$format -a $details prints valid JSON"
+        done
+    done
+    report json_details "$before"
+}
+
+test_diff_merge() {
+    before=$failures
+    in_netns ip addr add 10.9.0.1/24 dev lo
+    in_netns ip addr add 10.9.1.1/24 dev lo
+    in_netns ip addr add 10.9.3.1/24 dev lo
+    in_netns "$IFSHOW" --save "$TMP/state" || fail "--save exits 0"
+    in_netns ip addr del 10.9.1.1/24 dev lo    # '-'
+    in_netns ip addr add 10.9.2.1/24 dev lo    # '+'
+    in_netns ip addr del 10.9.0.1/24 dev lo    # '~': same address, another prefix
+    in_netns ip addr add 10.9.0.1/16 dev lo
+    in_netns "$IFSHOW" --diff "$TMP/state" > "$TMP/got" || fail "--diff exits 0"
+    cat > "$TMP/want" <<EOF
+~ lo 10.9.0.1/16 (255.255.0.0)
+- lo 10.9.1.1/24 (255.255.255.0)
++ lo 10.9.2.1/24 (255.255.255.0)
+EOF
+    cmp -s "$TMP/want" "$TMP/got" || fail "--diff reports one '~', '-' and '+' line, in state order"
+    in_netns "$IFSHOW" --diff "$TMP/state" --save "$TMP/state" > /dev/null || fail "--diff --save on one file exits 0"
+    out=$(in_netns "$IFSHOW" --diff "$TMP/state")
+    [ -z "$out" ] || fail "--diff after --diff --save prints nothing"
+    report diff_merge "$before"
+}
+
+test_link_only() {
+    before=$failures
+    if ! in_netns ip link add ifshow-v0 type veth peer name ifshow-v1 2>/dev/null; then
+        echo "skip link_only (no veth support)"
+        return
+    fi
+    in_netns "$IFSHOW" -a -l > "$TMP/got" || fail "-a -l exits 0"
+    grep -q '^ifshow-v0:$' "$TMP/got" || fail "-a -l lists a link without addresses"
+    grep -A1 '^ifshow-v0:$' "$TMP/got" | grep -q '^ \* link DOWN,BROADCAST,MULTICAST mtu 1500 hwaddr ' ||
+        fail "-a -l prints its link line right under its header"
+    grep -q 'not found' "$TMP/got" && fail "-a -l does not call a link without addresses missing"
+    in_netns "$IFSHOW" -a --stats | grep -A1 '^ifshow-v1:$' | grep -q '^ \* rx ' || fail "-a --stats lists it too"
+    for format in json ndjson openmetrics; do
+        in_netns "$IFSHOW" -a -l --format=$format > "$TMP/got" || fail "-a -l --format=$format exits 0"
+        grep -q '"ifshow-v0"' "$TMP/got" || fail "-a -l --format=$format lists the link without addresses"
+    done
+    in_netns "$IFSHOW" -a -l --json | grep -q '{"ifname":"ifshow-v0","addresses":\[\],"link":{"flags":\["BROADCAST","MULTICAST"\]' ||
+        fail "--json -a -l prints it with empty addresses and its link"
+    report link_only "$before"
+}
+
+test_bin_round_trip
+test_save_diff
+if command -v python3 >/dev/null 2>&1; then
+    test_json_details
+else
+    echo "skip json_details (needs python3)"
+fi
+if have_netns; then
+    test_diff_merge
+    test_link_only
+else
+    echo "skip diff_merge (needs root and ip netns)"
+    echo "skip link_only (needs root and ip netns)"
+fi
+
+[ "$failures" -eq 0 ] || echo "$failures check(s) failed" >&2
+[ "$failures" -eq 0 ]
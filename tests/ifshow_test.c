@@ -0,0 +1,965 @@
+/*
+ * ifshow_test - Unit tests of libifshow: formatting, masks, filters, globs, snapshots, owners, counts, summaries, bin documents.
+ * FR: ifshow_test - Tests unitaires de libifshow : formatage, masques, filtres, globs, snapshots, propriétaires, comptages, résumés, documents bin.
+ *
+ * Build / Compilation (from the repository root, after building libifshow.a):
+ *   gcc -Wall -Wextra -O2 -o tests/ifshow_test tests/ifshow_test.c libifshow.a
+ *
+ * Usage / Utilisation:
+ * - tests/ifshow_test. EN: Run every test; prints the failed checks and exits 1 if any.
+ *   FR: Lance tous les tests ; affiche les vérifications en échec et sort avec 1 s'il y en a.
+ *
+ * Internals are reached through libifshow_internal.h, the public API through
+ * ifshow.h; tests/run.sh builds everything and also runs tests/cli_test.sh.
+ */
+
+#include "../ifshow.h"
+#include "../libifshow_internal.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures; // checks that failed so far
+
+/**
+ * @brief Record the outcome of one check, reporting it when it failed.
+ */
+static void check(int ok, const char *what, const char *file, int line) {
+    if (ok) return;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    failures++;
+}
+
+#define CHECK(cond) check((cond) != 0, #cond, __FILE__, __LINE__)
+
+/**
+ * @brief Check two strings for equality, printing both when they differ.
+ */
+#define CHECK_STR(got, want)                                                                      \
+    do {                                                                                          \
+        const char *got_ = (got), *want_ = (want);                                                \
+        check(strcmp(got_, want_) == 0, #got " == \"" #want "\"", __FILE__, __LINE__);            \
+        if (strcmp(got_, want_) != 0) fprintf(stderr, "  got:  %s\n  want: %s\n", got_, want_); \
+    } while (0)
+
+/**
+ * @brief Deterministic xorshift generator, so failures reproduce.
+ */
+static uint32_t test_random(void) {
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/**
+ * @brief Append "<address>[/<prefix>]" to a snapshot under `ifname`.
+ *
+ * Exits on a malformed address: the tables below are fixed.
+ *
+ * @param s       Snapshot.
+ * @param ifname  Interface name.
+ * @param text    Address, with an optional prefix (none: no netmask known).
+ * @param scope   enum addr_scope.
+ */
+static void snap_add(struct snapshot *s, const char *ifname, const char *text, int scope) {
+    char addr[INET6_ADDRSTRLEN];
+    const char *slash = strchr(text, '/');
+    size_t len = slash ? (size_t)(slash - text) : strlen(text);
+    memcpy(addr, text, len);
+    addr[len] = '\0';
+    struct addr_info ai = { .ifname = ifname, .family = strchr(addr, ':') ? AF_INET6 : AF_INET, .scope = scope };
+    ai.prefix = slash ? atoi(slash + 1) : -1;
+    if (inet_pton(ai.family, addr, ai.addr) != 1) {
+        fprintf(stderr, "bad test address %s\n", text);
+        exit(EXIT_FAILURE);
+    }
+    snapshot_append(s, snapshot_intern(s, ifname), &ai);
+}
+
+/**
+ * @brief Print a snapshot through a printer into a fresh NUL-terminated string (free() it).
+ *
+ * @param s       Snapshot.
+ * @param format  Output format.
+ * @param seeded  As for print_snapshot().
+ * @param len     Receives the length, or NULL.
+ */
+static char *render(struct snapshot *s, enum output_format format, int seeded, size_t *len) {
+    struct outbuf ob = { .fd = -1 };
+    struct printer p = { .ops = printer_ops_for(format), .ob = &ob };
+    print_snapshot(&p, s, seeded);
+    out_write(&ob, "", 1);
+    if (len) *len = ob.len - 1;
+    return ob.data;
+}
+
+/**
+ * @brief fmt_ipv4(), through addr_to_string(), matches inet_ntop.
+ */
+static void test_fmt_ipv4(void) {
+    static const char *const cases[] = { "0.0.0.0", "255.255.255.255", "10.0.0.1", "192.0.2.10", "100.64.9.99" };
+    char got[INET_ADDRSTRLEN], want[INET_ADDRSTRLEN];
+    unsigned char a[4];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        inet_pton(AF_INET, cases[i], a);
+        CHECK(addr_to_string(AF_INET, a, got, sizeof(got)) == (int)strlen(cases[i]));
+        CHECK_STR(got, cases[i]);
+    }
+    for (int i = 0; i < 100000; ++i) {
+        uint32_t v = test_random();
+        memcpy(a, &v, 4);
+        addr_to_string(AF_INET, a, got, sizeof(got));
+        inet_ntop(AF_INET, a, want, sizeof(want));
+        if (strcmp(got, want) != 0) {
+            CHECK_STR(got, want);
+            break;
+        }
+    }
+    inet_pton(AF_INET, "192.0.2.10", a);
+    CHECK(addr_to_string(AF_INET, a, got, 10) == -1); // "192.0.2.10" needs 11 bytes
+    CHECK(addr_to_string(AF_INET, a, got, 11) == 10);
+}
+
+/**
+ * @brief fmt_ipv6() matches inet_ntop: "::" placement, ties, IPv4-mapped and -compatible forms.
+ */
+static void test_fmt_ipv6(void) {
+    static const char *const cases[][2] = {
+        { "::", "::" },
+        { "::1", "::1" },
+        { "1::", "1::" },
+        { "::ffff:192.0.2.1", "::ffff:192.0.2.1" },   // IPv4-mapped
+        { "::192.0.2.1", "::192.0.2.1" },             // IPv4-compatible
+        { "::ffff:0:0", "::ffff:0.0.0.0" },
+        { "::2:3:4:5:6", "::2:3:4:5:6" },             // no dotted tail without the mapped prefix
+        { "2001:db8::1", "2001:db8::1" },
+        { "2001:0db8:0000:0000:0001:0000:0000:0001", "2001:db8::1:0:0:1" }, // tie: the first run wins
+        { "1:0:0:1:0:0:0:1", "1:0:0:1::1" },          // the longest run wins over an earlier one
+        { "1:0:1:1:1:1:1:1", "1:0:1:1:1:1:1:1" },     // a single zero group stays
+        { "fe80::1:2", "fe80::1:2" },
+        { "ABCD:EF01:2345:6789:ABCD:EF01:2345:6789", "abcd:ef01:2345:6789:abcd:ef01:2345:6789" },
+    };
+    char got[INET6_ADDRSTRLEN], want[INET6_ADDRSTRLEN];
+    unsigned char a[16];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        CHECK(inet_pton(AF_INET6, cases[i][0], a) == 1);
+        addr_to_string(AF_INET6, a, got, sizeof(got));
+        inet_ntop(AF_INET6, a, want, sizeof(want));
+        CHECK_STR(got, cases[i][1]);
+        CHECK_STR(got, want);
+    }
+    for (int i = 0; i < 200000; ++i) { // zero groups are frequent, so runs and ties are too
+        uint32_t bits = test_random();
+        for (int w = 0; w < 8; ++w) {
+            uint32_t v = (bits >> (2 * w)) & 3 ? 0 : test_random() & 0xffff;
+            if (w == 5 && (bits >> 30) == 1) v = 0xffff; // IPv4-mapped candidates
+            a[2 * w] = (unsigned char)(v >> 8);
+            a[2 * w + 1] = (unsigned char)v;
+        }
+        size_t n = fmt_ipv6(got, a);
+        got[n] = '\0';
+        inet_ntop(AF_INET6, a, want, sizeof(want));
+        if (strcmp(got, want) != 0) {
+            CHECK_STR(got, want);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Prefix length of a netmask given as text.
+ */
+static int prefix_of(int family, const char *mask) {
+    struct sockaddr_in6 sa;
+    memset(&sa, 0, sizeof(sa));
+    if (family == AF_INET) {
+        struct sockaddr_in *sin = (struct sockaddr_in *)&sa;
+        sin->sin_family = AF_INET;
+        inet_pton(AF_INET, mask, &sin->sin_addr);
+    } else {
+        sa.sin6_family = AF_INET6;
+        inet_pton(AF_INET6, mask, &sa.sin6_addr);
+    }
+    return count_prefix_length((const struct sockaddr *)&sa);
+}
+
+/**
+ * @brief count_prefix_length() on contiguous and non-contiguous IPv4/IPv6 masks.
+ */
+static void test_prefix_length(void) {
+    CHECK(prefix_of(AF_INET, "0.0.0.0") == 0);
+    CHECK(prefix_of(AF_INET, "128.0.0.0") == 1);
+    CHECK(prefix_of(AF_INET, "255.255.255.0") == 24);
+    CHECK(prefix_of(AF_INET, "255.255.255.254") == 31);
+    CHECK(prefix_of(AF_INET, "255.255.255.255") == 32);
+    CHECK(prefix_of(AF_INET, "255.0.255.0") == PREFIX_NONCONTIGUOUS);
+    CHECK(prefix_of(AF_INET, "0.255.255.255") == PREFIX_NONCONTIGUOUS);
+    CHECK(prefix_of(AF_INET, "255.255.255.1") == PREFIX_NONCONTIGUOUS);
+    CHECK(prefix_of(AF_INET6, "::") == 0);
+    CHECK(prefix_of(AF_INET6, "ffff:ffff:ffff:ffff::") == 64);
+    CHECK(prefix_of(AF_INET6, "ffff:ffff:ffff:ffff:8000::") == 65);
+    CHECK(prefix_of(AF_INET6, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff") == 128);
+    CHECK(prefix_of(AF_INET6, "ffff:ffff:ffff:fffe::") == 63);
+    CHECK(prefix_of(AF_INET6, "ff00::ff") == PREFIX_NONCONTIGUOUS);
+    CHECK(prefix_of(AF_INET6, "ffff:ffff:ffff:ffff:0:0:0:1") == PREFIX_NONCONTIGUOUS); // in the second word
+    CHECK(count_prefix_length(NULL) == -1);
+    struct sockaddr other = { .sa_family = AF_UNIX };
+    CHECK(count_prefix_length(&other) == -1);
+}
+
+/**
+ * @brief addr_filter_add_net(): what --in accepts and what it matches.
+ */
+static void test_filter_net(void) {
+    static const char *const good[] = { "10.0.0.0/8", "0.0.0.0/0", "192.0.2.1", "192.0.2.1/32", "fd00::/8", "::/0", "fe80::1" };
+    static const char *const bad[] = { "10.1.2.3/8", "10.0.0.0/+8", "10.0.0.0/ 8", "10.0.0.0/", "10.0.0.0/33",
+                                       "10.0.0.0/8x", "10.0.0.0/-1", "fe80::1/64", "::/129", "/8", "eth0" };
+    for (size_t i = 0; i < sizeof(good) / sizeof(good[0]); ++i) {
+        struct addr_filter f = {0};
+        check(addr_filter_add_net(&f, good[i]) == 0, good[i], __FILE__, __LINE__);
+        free(f.nets);
+    }
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        struct addr_filter f = {0};
+        check(addr_filter_add_net(&f, bad[i]) == -1, bad[i], __FILE__, __LINE__);
+        free(f.nets);
+    }
+    struct addr_filter f = {0};
+    addr_filter_add_net(&f, "10.0.0.0/8");
+    addr_filter_add_net(&f, "2001:db8::/32");
+    struct addr_info in4 = { .family = AF_INET, .addr = { 10, 200, 0, 1 } };
+    struct addr_info out4 = { .family = AF_INET, .addr = { 11, 0, 0, 1 } };
+    struct addr_info in6 = { .family = AF_INET6, .addr = { 0x20, 0x01, 0x0d, 0xb8, [15] = 1 } };
+    struct addr_info out6 = { .family = AF_INET6, .addr = { 0x20, 0x01, 0x0d, 0xb9, [15] = 1 } };
+    CHECK(addr_filter_match(&f, &in4));
+    CHECK(!addr_filter_match(&f, &out4));
+    CHECK(addr_filter_match(&f, &in6));
+    CHECK(!addr_filter_match(&f, &out6));
+    free(f.nets);
+}
+
+/**
+ * @brief Compile `pattern` and match it against `name`.
+ */
+static int glob_matches(const char *pattern, const char *name) {
+    struct name_glob g;
+    name_glob_compile(&g, pattern);
+    int m = name_glob_match(&g, name);
+    name_glob_free(&g);
+    return m;
+}
+
+/**
+ * @brief -i patterns: wildcards, classes, escapes and backtracking.
+ */
+static void test_glob(void) {
+    CHECK(name_is_glob("veth*") && name_is_glob("eth?") && name_is_glob("eth[0-3]"));
+    CHECK(!name_is_glob("eth0") && !name_is_glob("eth0.100") && !name_is_glob("br-lan"));
+    CHECK(glob_matches("veth*", "veth") && glob_matches("veth*", "veth0a1b"));
+    CHECK(!glob_matches("veth*", "vet") && !glob_matches("veth*", "xveth0"));
+    CHECK(glob_matches("eth?", "eth0") && !glob_matches("eth?", "eth") && !glob_matches("eth?", "eth10"));
+    CHECK(glob_matches("eth[0-3]", "eth0") && glob_matches("eth[0-3]", "eth3"));
+    CHECK(!glob_matches("eth[0-3]", "eth4") && !glob_matches("eth[0-3]", "eth10"));
+    CHECK(glob_matches("eth[!0-3]", "eth7") && !glob_matches("eth[!0-3]", "eth2"));
+    CHECK(glob_matches("eth[^0-3]", "ethx") && !glob_matches("eth[^0-3]", "eth1"));
+    CHECK(glob_matches("[]x]", "]") && glob_matches("[]x]", "x")); // a leading ']' is a member
+    CHECK(glob_matches("*.100", "eth0.100") && !glob_matches("*.100", "eth0.1000"));
+    CHECK(glob_matches("a*b*c", "aXbYbZc") && !glob_matches("a*b*c", "aXbYcZ")); // backtracking over the last '*'
+    CHECK(glob_matches("*", "") && glob_matches("**", "lo") && glob_matches("*o", "lo"));
+    CHECK(glob_matches("\\*", "*") && !glob_matches("\\*", "x"));
+    CHECK(glob_matches("eth[0", "eth[0") && !glob_matches("eth[0", "eth0")); // unterminated '[' is literal
+}
+
+/**
+ * @brief snapshot_intern() / snapshot_find() across table growth, with names copied into the arena.
+ */
+static void test_intern(void) {
+    struct snapshot s = {0};
+    CHECK(snapshot_find(&s, "eth0") == SNAP_NONE); // no table yet
+    char name[IF_NAMESIZE];
+    int stable = 1;
+    for (uint32_t i = 0; i < 5000; ++i) { // many rehashes; backends only lend their names
+        snprintf(name, sizeof(name), "veth%u", i);
+        if (snapshot_intern(&s, name) != i) stable = 0;
+        memset(name, 'x', sizeof(name) - 1);
+        if (i % 7 == 0 && snapshot_intern(&s, "veth0") != 0) stable = 0;
+    }
+    CHECK(stable && s.name_count == 5000);
+    CHECK(s.slot_mask + 1 >= 2 * s.name_count); // load <= 50%
+    int found = 1;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        snprintf(name, sizeof(name), "veth%u", i);
+        if (snapshot_find(&s, name) != i || strcmp(s.names[i].name, name) != 0) found = 0;
+    }
+    CHECK(found);
+    CHECK(snapshot_find(&s, "veth5000") == SNAP_NONE && snapshot_find(&s, "veth") == SNAP_NONE);
+    CHECK(snapshot_find(&s, "") == SNAP_NONE && snapshot_intern(&s, "") == 5000);
+    snapshot_free(&s);
+    CHECK(s.name_count == 0 && s.slots == NULL && snapshot_find(&s, "veth1") == SNAP_NONE);
+    CHECK(snapshot_intern(&s, "lo") == 0); // reusable after snapshot_free()
+    snapshot_free(&s);
+}
+
+/**
+ * @brief snapshot_group(): one run per name, names first-seen, addresses in backend order, no interface cap.
+ */
+static void test_group(void) {
+    struct snapshot s = {0};
+    char name[IF_NAMESIZE];
+    for (int i = 0; i < 3000; ++i) { // interleaved: address i belongs to veth<i % 1000>
+        snprintf(name, sizeof(name), "veth%d", i % 1000);
+        struct addr_info ai = { .ifname = name, .family = AF_INET, .prefix = 32, .addr = { 10, (unsigned char)(i >> 8), (unsigned char)i, 1 } };
+        snapshot_add(&ai, &s);
+    }
+    snapshot_group(&s);
+    CHECK(s.name_count == 1000 && s.addr_count == 3000);
+    int grouped = 1;
+    for (uint32_t n = 0; n < s.name_count; ++n) {
+        snprintf(name, sizeof(name), "veth%u", n);
+        if (strcmp(s.names[n].name, name) != 0 || s.names[n].count != 3 || s.names[n].first != 3 * n) grouped = 0;
+        for (uint32_t j = 0; j < s.names[n].count; ++j) {
+            if (s.order[s.names[n].first + j] != n + 1000 * j) grouped = 0;
+        }
+    }
+    CHECK(grouped);
+    snapshot_free(&s);
+
+    struct snapshot k = {0}; // seeded as for -i: only those names, in that order, even without addresses
+    snapshot_intern(&k, "wan0");
+    snapshot_intern(&k, "lo");
+    snapshot_intern(&k, "eth0");
+    static const char *const seen[][2] = { { "lo", "127.0.0.1" }, { "eth9", "10.9.9.9" }, { "eth0", "10.0.0.1" }, { "lo", "127.0.0.2" } };
+    for (size_t i = 0; i < sizeof(seen) / sizeof(seen[0]); ++i) {
+        struct addr_info ai = { .ifname = seen[i][0], .family = AF_INET, .prefix = 8, .scope = SCOPE_HOST };
+        inet_pton(AF_INET, seen[i][1], ai.addr);
+        snapshot_add_known(&ai, &k);
+    }
+    CHECK(k.name_count == 3 && k.addr_count == 3);
+    char *text = render(&k, FORMAT_TEXT, 1, NULL);
+    CHECK_STR(text, "wan0:\nInterface 'wan0' not found or has no IP.\n\n"
+                    "lo:\n - 127.0.0.1/8 (255.0.0.0)\n - 127.0.0.2/8 (255.0.0.0)\n\neth0:\n - 10.0.0.1/8 (255.0.0.0)\n\n");
+    free(text);
+    snapshot_free(&k);
+}
+
+/**
+ * @brief Records of a snapshot in array order as "<ifname> <address>/<prefix>;", then "| <names...>".
+ */
+static const char *records_of(const struct snapshot *s) {
+    static char buf[1024];
+    size_t len = 0;
+    for (uint32_t i = 0; i < s->addr_count; ++i) {
+        char ip[INET6_ADDRSTRLEN];
+        addr_to_string(s->addrs[i].family, s->addrs[i].addr, ip, sizeof(ip));
+        len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s %s/%d;", s->names[s->addrs[i].name].name, ip, s->addrs[i].prefix);
+    }
+    len += (size_t)snprintf(buf + len, sizeof(buf) - len, "|");
+    for (uint32_t i = 0; i < s->name_count; ++i) len += (size_t)snprintf(buf + len, sizeof(buf) - len, " %s", s->names[i].name);
+    return buf;
+}
+
+/**
+ * @brief Interfaces with an alias label sharing eth0's ifindex, listed out of every order; "wan0" has no address.
+ */
+static void sort_fixture(struct snapshot *s) {
+    static const struct { const char *ifname, *addr; uint32_t ifindex; } rows[] = {
+        { "eth1", "10.0.1.1/24", 3 },  { "eth0:1", "10.0.0.9/24", 2 }, { "lo", "127.0.0.1/8", 1 },
+        { "eth0", "10.0.0.5/24", 2 },  { "eth1", "2001:db8::1/64", 3 }, { "eth0", "10.0.0.1/24", 2 },
+        { "eth1", "10.0.0.5/24", 3 },  { "lo", "::1/128", 1 },
+    };
+    snapshot_intern(s, "wan0");
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); ++i) {
+        snap_add(s, rows[i].ifname, rows[i].addr, SCOPE_GLOBAL);
+        s->addrs[s->addr_count - 1].ifindex = rows[i].ifindex;
+    }
+}
+
+/**
+ * @brief Reference order of two records, as documented for enum sort_order.
+ */
+static int sort_ref_cmp(const struct snapshot *s, const struct snap_addr *x, const struct snap_addr *y, enum sort_order order) {
+    int c = 0;
+    if (order == SORT_INDEX && x->ifindex != y->ifindex) return x->ifindex < y->ifindex ? -1 : 1;
+    if (order != SORT_ADDR && (c = strcmp(s->names[x->name].name, s->names[y->name].name))) return c;
+    if (x->family != y->family) return x->family == AF_INET ? -1 : 1;
+    if ((c = memcmp(x->addr, y->addr, 16))) return c;
+    if (x->prefix != y->prefix) return x->prefix < y->prefix ? -1 : 1;
+    return order == SORT_ADDR ? strcmp(s->names[x->name].name, s->names[y->name].name) : 0;
+}
+
+/**
+ * @brief snapshot_sort(): index, name and address orders with alias labels, ties and renumbered names.
+ */
+static void test_sort(void) {
+    static const struct { enum sort_order order; const char *want; } cases[] = {
+        { SORT_INDEX, "lo 127.0.0.1/8;lo ::1/128;eth0 10.0.0.1/24;eth0 10.0.0.5/24;eth0:1 10.0.0.9/24;"
+                      "eth1 10.0.0.5/24;eth1 10.0.1.1/24;eth1 2001:db8::1/64;| lo eth0 eth0:1 eth1 wan0" },
+        { SORT_NAME, "eth0 10.0.0.1/24;eth0 10.0.0.5/24;eth0:1 10.0.0.9/24;eth1 10.0.0.5/24;eth1 10.0.1.1/24;"
+                     "eth1 2001:db8::1/64;lo 127.0.0.1/8;lo ::1/128;| eth0 eth0:1 eth1 lo wan0" },
+        { SORT_ADDR, "eth0 10.0.0.1/24;eth0 10.0.0.5/24;eth1 10.0.0.5/24;eth0:1 10.0.0.9/24;eth1 10.0.1.1/24;"
+                     "lo 127.0.0.1/8;lo ::1/128;eth1 2001:db8::1/64;| eth0 eth1 eth0:1 lo wan0" },
+        { SORT_NONE, "eth1 10.0.1.1/24;eth0:1 10.0.0.9/24;lo 127.0.0.1/8;eth0 10.0.0.5/24;eth1 2001:db8::1/64;"
+                     "eth0 10.0.0.1/24;eth1 10.0.0.5/24;lo ::1/128;| wan0 eth1 eth0:1 lo eth0" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        struct snapshot s = {0};
+        sort_fixture(&s);
+        snapshot_sort(&s, cases[i].order);
+        CHECK_STR(records_of(&s), cases[i].want);
+        int found = 1; // the name table follows the renumbering
+        for (uint32_t n = 0; n < s.name_count; ++n) found &= snapshot_find(&s, s.names[n].name) == n;
+        CHECK(found);
+        snapshot_free(&s);
+    }
+
+    // Random tables: the radix sort agrees with the reference order.
+    static const enum sort_order orders[] = { SORT_INDEX, SORT_NAME, SORT_ADDR };
+    for (size_t o = 0; o < 3; ++o) {
+        struct snapshot s = {0};
+        for (int i = 0; i < 3000; ++i) {
+            char name[IF_NAMESIZE], text[64];
+            uint32_t v = test_random(), w = test_random();
+            unsigned int ifn = v % 40;
+            snprintf(name, sizeof(name), v & 0x100 ? "eth%u:%u" : "eth%u", ifn, (v >> 9) % 3);
+            if (v & 0x200) {
+                snprintf(text, sizeof(text), "2001:db8:%x::%x/%u", w % 3, (w >> 8) % 5, 48 + (w >> 16) % 3 * 16);
+            } else {
+                snprintf(text, sizeof(text), "10.%u.%u.%u/%u", w % 2, (w >> 8) % 3, (w >> 12) % 256, 8 + (w >> 24) % 25);
+            }
+            snap_add(&s, name, text, SCOPE_GLOBAL);
+            s.addrs[s.addr_count - 1].ifindex = ifn + 1; // aliases share their device's index
+        }
+        snapshot_sort(&s, orders[o]);
+        int sorted = s.addr_count == 3000;
+        for (uint32_t i = 1; i < s.addr_count; ++i) {
+            if (sort_ref_cmp(&s, &s.addrs[i - 1], &s.addrs[i], orders[o]) > 0) sorted = 0;
+        }
+        check(sorted, "random table sorted", __FILE__, __LINE__);
+        snapshot_free(&s);
+    }
+}
+
+/**
+ * @brief "<ifname>/<matched length>" of the longest prefix containing `query`, or "-".
+ */
+static const char *owner_of(const struct prefix_trie *t, const struct snapshot *s, const char *query) {
+    static char buf[64];
+    unsigned char key[16] = {0};
+    int v6 = strchr(query, ':') != NULL;
+    inet_pton(v6 ? AF_INET6 : AF_INET, query, key);
+    const struct trie_node *n = prefix_trie_lookup(t, v6, key);
+    if (!n) return "-";
+    snprintf(buf, sizeof(buf), "%s/%d", s->names[s->addrs[n->entry].name].name, n->len);
+    return buf;
+}
+
+/**
+ * @brief Whether the first `len` bits of `a` and `b` agree.
+ */
+static int same_bits(const unsigned char *a, const unsigned char *b, int len) {
+    for (int i = 0; i < len; ++i) {
+        if (((a[i / 8] ^ b[i / 8]) >> (7 - i % 8)) & 1) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief --owner trie: longest-prefix matches over nested prefixes and hosts, against a linear scan.
+ */
+static void test_owner_trie(void) {
+    struct snapshot s = {0};
+    snap_add(&s, "eth8", "10.0.0.1/8", SCOPE_GLOBAL);
+    snap_add(&s, "eth16", "10.1.0.1/16", SCOPE_GLOBAL);
+    snap_add(&s, "eth24", "10.1.2.1/24", SCOPE_GLOBAL);
+    snap_add(&s, "eth25", "10.1.2.129/25", SCOPE_GLOBAL);
+    snap_add(&s, "lo", "10.1.2.200/32", SCOPE_HOST);
+    snap_add(&s, "dup", "10.1.2.2/24", SCOPE_GLOBAL); // same network as eth24: the first interface keeps it
+    snap_add(&s, "eth8", "2001:db8::1/32", SCOPE_GLOBAL);
+    snap_add(&s, "eth16", "2001:db8:1::1/48", SCOPE_GLOBAL);
+    snap_add(&s, "lo", "::1/128", SCOPE_HOST);
+    struct prefix_trie t = {0};
+    prefix_trie_build(&t, &s);
+    CHECK_STR(owner_of(&t, &s, "10.9.9.9"), "eth8/8");
+    CHECK_STR(owner_of(&t, &s, "10.1.9.9"), "eth16/16");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.5"), "eth24/24");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.127"), "eth24/24");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.128"), "eth25/25");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.200"), "lo/32");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.201"), "eth25/25");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.1"), "eth24/32");  // an address is owned by its own interface
+    CHECK_STR(owner_of(&t, &s, "10.1.2.2"), "dup/32");
+    CHECK_STR(owner_of(&t, &s, "10.1.2.3"), "eth24/24");
+    CHECK_STR(owner_of(&t, &s, "11.0.0.1"), "-");
+    CHECK_STR(owner_of(&t, &s, "9.255.255.255"), "-");
+    CHECK_STR(owner_of(&t, &s, "2001:db8:1:2::3"), "eth16/48");
+    CHECK_STR(owner_of(&t, &s, "2001:db8:2::3"), "eth8/32");
+    CHECK_STR(owner_of(&t, &s, "::1"), "lo/128");
+    CHECK_STR(owner_of(&t, &s, "::2"), "-");
+    snapshot_free(&s);
+
+    // Random overlapping prefixes: the trie agrees with the first longest match in grouped order.
+    static const int lens[] = { 8, 12, 16, 20, 23, 24, 25, 28, 30, 31, 32 };
+    struct snapshot r = {0};
+    for (int i = 0; i < 400; ++i) {
+        char name[IF_NAMESIZE], text[32];
+        uint32_t v = test_random();
+        snprintf(name, sizeof(name), "eth%u", v % 37);
+        snprintf(text, sizeof(text), "10.%u.%u.%u/%d", (v >> 8) % 4, (v >> 12) % 8, v >> 24, lens[(v >> 16) % 11]);
+        snap_add(&r, name, text, SCOPE_GLOBAL);
+    }
+    t = (struct prefix_trie){0};
+    prefix_trie_build(&t, &r);
+    int agree = 1;
+    for (int q = 0; q < 20000 && agree; ++q) {
+        uint32_t v = test_random();
+        unsigned char key[16] = { 10, (unsigned char)((v >> 8) % 5), (unsigned char)((v >> 12) % 9), (unsigned char)(v >> 24) };
+        size_t best = TRIE_NONE;
+        int best_len = -1;
+        for (uint32_t i = 0; i < r.addr_count; ++i) {
+            const struct snap_addr *a = &r.addrs[r.order[i]];
+            if (same_bits(a->addr, key, 32) && best_len < 32) { // the host itself, then its network
+                best = r.order[i];
+                best_len = 32;
+            } else if (same_bits(a->addr, key, a->prefix) && best_len < a->prefix) {
+                best = r.order[i];
+                best_len = a->prefix;
+            }
+        }
+        const struct trie_node *n = prefix_trie_lookup(&t, 0, key);
+        if (best == TRIE_NONE ? n != NULL : !n || n->entry != best || n->len != best_len) agree = 0;
+    }
+    CHECK(agree);
+    snapshot_free(&r);
+}
+
+/**
+ * @brief Feed "<ifname> <address>" to count_visit(); returns the index of the address that stopped it, or -1.
+ */
+static int count_feed(struct count_table *t, const char *const (*rows)[2], size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        struct addr_info ai = { .ifname = rows[i][0], .family = strchr(rows[i][1], ':') ? AF_INET6 : AF_INET, .ifindex = 1 + (unsigned)i };
+        inet_pton(ai.family, rows[i][1], ai.addr);
+        if (count_visit(&ai, t)) return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief --count / --exists tables: per-family counts, -i names only, and the --exists early stop.
+ */
+static void test_count(void) {
+    static const char *const rows[][2] = {
+        { "eth0", "10.0.0.1" }, { "eth9", "10.9.0.1" }, { "eth0", "fe80::1" }, { "eth0", "10.0.0.2" },
+        { "lo", "127.0.0.1" }, { "eth0", "2001:db8::1" }, { "lo", "::1" },
+    };
+    const size_t n = sizeof(rows) / sizeof(rows[0]);
+    struct count_table all = {0};
+    count_table_seed(&all, NULL, 0, 0);
+    CHECK(count_feed(&all, rows, n) == -1);
+    CHECK(all.names.name_count == 3 && !all.known_only);
+    CHECK(all.entries[0].inet == 2 && all.entries[0].inet6 == 2 && all.entries[0].ifindex == 1);
+    CHECK(all.entries[1].inet == 1 && all.entries[1].inet6 == 0);
+    CHECK(all.entries[2].inet == 1 && all.entries[2].inet6 == 1 && all.entries[2].ifindex == 5);
+    snapshot_free(&all.names);
+    free(all.entries);
+
+    const char *const wanted[] = { "lo", "wan0", "eth0" };
+    struct count_table some = {0};
+    count_table_seed(&some, wanted, 3, 0);
+    CHECK(count_feed(&some, rows, n) == -1);
+    CHECK(some.names.name_count == 3 && snapshot_find(&some.names, "eth9") == SNAP_NONE); // others are ignored
+    CHECK(some.entries[0].inet == 1 && some.entries[0].inet6 == 1);
+    CHECK(some.entries[1].inet == 0 && some.entries[1].inet6 == 0);
+    CHECK(some.entries[2].inet == 2 && some.entries[2].inet6 == 2);
+    snapshot_free(&some.names);
+    free(some.entries);
+
+    const char *const present[] = { "lo", "eth0" };
+    struct count_table exists = {0};
+    count_table_seed(&exists, present, 2, 1);
+    CHECK(count_feed(&exists, rows, n) == 4 && exists.missing == 0); // stops at lo's first address
+    snapshot_free(&exists.names);
+    free(exists.entries);
+    exists = (struct count_table){0};
+    count_table_seed(&exists, wanted, 3, 1);
+    CHECK(count_feed(&exists, rows, n) == -1 && exists.missing == 1); // wan0 never shows up
+    snapshot_free(&exists.names);
+    free(exists.entries);
+
+    struct count_table many = {0}; // the entries grow past their first allocation
+    count_table_seed(&many, NULL, 0, 0);
+    int counted = 1;
+    for (unsigned int i = 0; i < 1000; ++i) {
+        char name[IF_NAMESIZE];
+        snprintf(name, sizeof(name), "veth%u", i % 500);
+        struct addr_info ai = { .ifname = name, .family = AF_INET, .addr = { 10, 0, (unsigned char)(i >> 8), (unsigned char)i } };
+        count_visit(&ai, &many);
+    }
+    for (uint32_t i = 0; i < many.names.name_count; ++i) counted &= many.entries[i].name == i && many.entries[i].inet == 2;
+    CHECK(counted && many.names.name_count == 500);
+    snapshot_free(&many.names);
+    free(many.entries);
+}
+
+/**
+ * @brief Summarize `addrs` on one interface and return the remaining records as text.
+ */
+static char *summarize(const char *const *addrs, size_t count) {
+    struct snapshot s = {0};
+    for (size_t i = 0; i < count; ++i) snap_add(&s, "eth0", addrs[i], SCOPE_GLOBAL);
+    snapshot_summarize(&s);
+    char *text = render(&s, FORMAT_TEXT, 0, NULL);
+    snapshot_free(&s);
+    return text;
+}
+
+/**
+ * @brief --summarize merges sibling hosts into the prefix they fill, and absorbs hosts a merged block covers.
+ */
+static void test_summarize_siblings(void) {
+    static const char *const run[] = { "10.0.0.15/32", "10.0.0.14/32", "10.0.0.13/32", "10.0.0.12/32", "10.0.0.11/32",
+                                       "10.0.0.10/32", "10.0.0.9/32", "10.0.0.8/32", "10.0.0.7/32", "10.0.0.6/32",
+                                       "10.0.0.5/32", "10.0.0.4/32", "10.0.0.3/32", "10.0.0.2/32", "10.0.0.1/32", "10.0.0.0/32" };
+    char *text = summarize(run, 16);
+    CHECK_STR(text, "eth0:\n - 10.0.0.0/28 (255.255.255.240)\n\n");
+    free(text);
+    static const char *const hosts[] = { "192.0.2.4/32", "192.0.2.5/32", "192.0.2.6/32", "192.0.2.7/32", "2001:db8::1/128" };
+    text = summarize(hosts, 5);
+    CHECK_STR(text, "eth0:\n - 192.0.2.4/30 (255.255.255.252)\n - 2001:db8::1/128\n\n");
+    free(text);
+    static const char *const dup[] = { "192.0.2.2/32", "192.0.2.3/32", "192.0.2.0/32", "192.0.2.1/32", "192.0.2.3/32",
+                                       "192.0.2.8", "192.0.2.9/32" }; // a duplicate host, and one without a netmask
+    text = summarize(dup, 7);
+    CHECK_STR(text, "eth0:\n - 192.0.2.0/30 (255.255.255.252)\n - 192.0.2.8/31 (255.255.255.254)\n\n");
+    free(text);
+}
+
+/**
+ * @brief --summarize prints every address that is not a host unchanged, and lets it absorb nothing.
+ */
+static void test_summarize_keeps(void) {
+    static const char *const onlink[] = { "10.0.0.9/24", "10.0.0.5/24" };
+    char *text = summarize(onlink, 2);
+    CHECK_STR(text, "eth0:\n - 10.0.0.5/24 (255.255.255.0)\n - 10.0.0.9/24 (255.255.255.0)\n\n");
+    free(text);
+    static const char *const inside[] = { "10.0.0.7/32", "10.0.0.0/24" };
+    text = summarize(inside, 2);
+    CHECK_STR(text, "eth0:\n - 10.0.0.0/24 (255.255.255.0)\n - 10.0.0.7/32 (255.255.255.255)\n\n");
+    free(text);
+    // Non-adjacent hosts, and two configured halves of a /24 around an on-link address.
+    static const char *const mixed[] = { "10.0.0.1/32", "10.0.0.3/32", "10.0.1.128/25", "10.0.1.5/24", "10.0.1.0/25" };
+    text = summarize(mixed, 5);
+    CHECK_STR(text, "eth0:\n - 10.0.0.1/32 (255.255.255.255)\n - 10.0.0.3/32 (255.255.255.255)\n"
+                    " - 10.0.1.0/25 (255.255.255.128)\n - 10.0.1.5/24 (255.255.255.0)\n - 10.0.1.128/25 (255.255.255.128)\n\n");
+    free(text);
+    // 10.1.0.8/29 sits on its network boundary but is a configured address, not the hosts 10.1.0.8-15.
+    static const char *const boundary[] = { "10.1.0.0/32", "10.1.0.1/32", "10.1.0.2/32", "10.1.0.3/32", "10.1.0.4/32",
+                                            "10.1.0.5/32", "10.1.0.6/32", "10.1.0.7/32", "10.1.0.8/29", "10.1.0.9/32" };
+    text = summarize(boundary, 10);
+    CHECK_STR(text, "eth0:\n - 10.1.0.0/29 (255.255.255.248)\n - 10.1.0.8/29 (255.255.255.248)\n"
+                    " - 10.1.0.9/32 (255.255.255.255)\n\n");
+    free(text);
+}
+
+/**
+ * @brief -l link lines: flag names after UP or DOWN, never a dangling separator.
+ */
+static void test_link_flags(void) {
+    static const struct { unsigned int flags; const char *text, *json; } cases[] = {
+        { IFF_UP | IFF_BROADCAST | IFF_MULTICAST, " * link UP,BROADCAST,MULTICAST mtu 1500\n", "[\"UP\",\"BROADCAST\",\"MULTICAST\"]" },
+        { IFF_BROADCAST | IFF_MULTICAST, " * link DOWN,BROADCAST,MULTICAST mtu 1500\n", "[\"BROADCAST\",\"MULTICAST\"]" },
+        { IFF_ALLMULTI, " * link DOWN mtu 1500\n", "[]" }, // set, but not a flag with a name
+        { 0, " * link DOWN mtu 1500\n", "[]" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        struct link_stats ls = { .ifindex = 2, .name = "eth0", .flags = cases[i].flags, .mtu = 1500 };
+        struct link_table t = { .links = &ls, .count = 1, .fields = LINK_LAYER };
+        struct snapshot s = {0};
+        snap_add(&s, "eth0", "192.0.2.1/24", SCOPE_GLOBAL);
+        snapshot_group(&s);
+        for (int json = 0; json < 2; ++json) {
+            struct outbuf ob = { .fd = -1 };
+            struct printer p = { .ops = printer_ops_for(json ? FORMAT_JSON : FORMAT_TEXT), .ob = &ob, .links = &t };
+            print_snapshot(&p, &s, 0);
+            out_write(&ob, "", 1);
+            const char *want = json ? cases[i].json : cases[i].text;
+            check(strstr(ob.data, want) != NULL, want, __FILE__, __LINE__);
+            if (!strstr(ob.data, want)) fprintf(stderr, "  got:  %s\n", ob.data);
+            free(ob.data);
+        }
+        snapshot_free(&s);
+    }
+}
+
+/**
+ * @brief A snapshot covering every record field: both families, unknown and non-contiguous masks, scopes.
+ *
+ * "wan0" is interned without addresses, so the snapshot is printed seeded.
+ */
+static void bin_fixture(struct snapshot *s) {
+    snap_add(s, "lo", "127.0.0.1/8", SCOPE_HOST);
+    snap_add(s, "lo", "::1/128", SCOPE_HOST);
+    snapshot_intern(s, "wan0");
+    snap_add(s, "eth0", "192.0.2.10/24", SCOPE_GLOBAL);
+    snap_add(s, "eth0", "fe80::1/64", SCOPE_LINK);
+    snap_add(s, "eth0:1", "198.51.100.7", SCOPE_GLOBAL); // no netmask known
+    struct addr_info odd = { .ifname = "eth0", .family = AF_INET, .prefix = PREFIX_NONCONTIGUOUS, .addr = { 10, 1, 2, 3 } };
+    snapshot_append(s, snapshot_find(s, "eth0"), &odd);
+    for (uint32_t i = 0; i < s->addr_count; ++i) s->addrs[i].ifindex = 7 + s->addrs[i].name;
+    snapshot_group(s);
+}
+
+/**
+ * @brief --format=bin documents decode back to the same names, records and output.
+ */
+static void test_bin_round_trip(void) {
+    struct snapshot s = {0}, back = {0};
+    bin_fixture(&s);
+    size_t len;
+    unsigned char *doc = (unsigned char *)render(&s, FORMAT_BIN, 1, &len);
+    CHECK(bin_decode(&back, doc, len, NULL) == 0);
+    CHECK(back.name_count == s.name_count && back.addr_count == s.addr_count);
+    for (uint32_t i = 0; i < s.name_count && i < back.name_count; ++i) CHECK_STR(back.names[i].name, s.names[i].name);
+    snapshot_group(&back);
+    for (uint32_t i = 0; i < s.addr_count && i < back.addr_count; ++i) {
+        const struct snap_addr *x = &s.addrs[s.order[i]], *y = &back.addrs[back.order[i]];
+        CHECK(memcmp(x->addr, y->addr, 16) == 0 && x->prefix == y->prefix && x->family == y->family &&
+              x->scope == y->scope && x->ifindex == y->ifindex);
+        CHECK_STR(back.names[y->name].name, s.names[x->name].name);
+    }
+    char *want = render(&s, FORMAT_TEXT, 1, NULL), *got = render(&back, FORMAT_TEXT, 1, NULL);
+    CHECK_STR(got, want);
+    free(got);
+    free(want);
+
+    struct addr_filter only6 = { .families = FILTER_INET6 };
+    struct snapshot v6 = {0};
+    CHECK(bin_decode(&v6, doc, len, &only6) == 0);
+    CHECK(v6.name_count == s.name_count && v6.addr_count == 2);
+    snapshot_free(&v6);
+    snapshot_free(&back);
+    snapshot_free(&s);
+    free(doc);
+}
+
+/**
+ * @brief Write a little-endian 32-bit value (test-side, to corrupt documents).
+ */
+static void poke_le32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+/**
+ * @brief Whether bin_decode() rejects a copy of the document with byte `at` set to `value`.
+ */
+static int bin_rejects(const unsigned char *doc, size_t len, size_t at, unsigned char value) {
+    unsigned char *copy = malloc(len);
+    memcpy(copy, doc, len);
+    copy[at] = value;
+    struct snapshot s = {0};
+    int rc = bin_decode(&s, copy, len, NULL);
+    snapshot_free(&s);
+    free(copy);
+    return rc == -1;
+}
+
+/**
+ * @brief bin_decode() rejects truncated, padded and corrupt documents (and survives any byte flip).
+ */
+static void test_bin_corrupt(void) {
+    struct snapshot s = {0};
+    bin_fixture(&s);
+    size_t len;
+    unsigned char *doc = (unsigned char *)render(&s, FORMAT_BIN, 1, &len);
+    snapshot_free(&s);
+    size_t names = 4, strings = len - 40 - names * 16 - 6 * 24; // layout from the header comment in libifshow.c
+    const size_t entries = 40, table = entries + names * 16, records = table + strings;
+
+    int truncated_ok = 1;
+    for (size_t n = 0; n < len; ++n) {
+        struct snapshot t = {0};
+        if (bin_decode(&t, doc, n, NULL) != -1) truncated_ok = 0;
+        snapshot_free(&t);
+    }
+    CHECK(truncated_ok);
+    unsigned char *padded = calloc(1, len + 8);
+    memcpy(padded, doc, len);
+    struct snapshot t = {0};
+    CHECK(bin_decode(&t, padded, len + 8, NULL) == -1); // the size field no longer matches
+    snapshot_free(&t);
+    free(padded);
+
+    CHECK(bin_rejects(doc, len, 0, 'X'));                      // magic
+    CHECK(bin_rejects(doc, len, 16, 2));                       // version
+    CHECK(bin_rejects(doc, len, 8, (unsigned char)(doc[8] + 1))); // size
+    CHECK(bin_rejects(doc, len, 28, (unsigned char)(doc[28] + 1))); // record count
+    CHECK(bin_rejects(doc, len, entries, 0xff));               // name offset past the string table
+    CHECK(bin_rejects(doc, len, entries + 4, 1));              // first name's records do not start at 0
+    CHECK(bin_rejects(doc, len, entries + 8, 0xff));           // record count past the records
+    CHECK(bin_rejects(doc, len, records + 16, 1));             // record names another entry
+    CHECK(bin_rejects(doc, len, records + 20, 33));            // IPv4 prefix past 32
+    CHECK(bin_rejects(doc, len, records + 22, 5));             // family
+    CHECK(bin_rejects(doc, len, records + 23, 9));             // scope
+    unsigned char *open_name = malloc(len);
+    memcpy(open_name, doc, len);
+    uint32_t last = (uint32_t)doc[entries + 3 * 16] | (uint32_t)doc[entries + 3 * 16 + 1] << 8; // "eth0:1"
+    memset(open_name + table + last, 'x', strings - last); // its terminator and the padding after it
+    CHECK(bin_decode(&t, open_name, len, NULL) == -1);
+    snapshot_free(&t);
+    free(open_name);
+    unsigned char *big = malloc(len);
+    memcpy(big, doc, len);
+    poke_le32(big + 24, 0x40000000u); // names * nsize overflows 32 bits
+    CHECK(bin_decode(&t, big, len, NULL) == -1);
+    snapshot_free(&t);
+    free(big);
+
+    for (size_t at = 0; at < len; ++at) { // no crash whatever the byte; ASan / valgrind catch overreads
+        for (int bit = 0; bit < 8; ++bit) {
+            unsigned char *copy = malloc(len);
+            memcpy(copy, doc, len);
+            copy[at] ^= (unsigned char)(1u << bit);
+            struct snapshot f = {0};
+            if (bin_decode(&f, copy, len, NULL) == 0) {
+                char *text = render(&f, FORMAT_TEXT, 1, NULL);
+                free(text);
+            }
+            snapshot_free(&f);
+            free(copy);
+        }
+    }
+    free(doc);
+}
+
+/**
+ * @brief Context of collect(): addresses visited through the public API, as text.
+ */
+struct collected {
+    char text[1024];
+    size_t len, count;
+};
+
+/**
+ * @brief ifshow_snapshot_foreach() visitor appending "<ifname> <address>/<prefix>;".
+ */
+static int collect(const struct ifshow_addr *addr, void *arg) {
+    struct collected *c = arg;
+    char ip[INET6_ADDRSTRLEN];
+    inet_ntop(addr->family, addr->addr, ip, sizeof(ip));
+    int n = snprintf(c->text + c->len, sizeof(c->text) - c->len, "%s %s/%d;", addr->ifname, ip, addr->prefix);
+    if (n > 0 && (size_t)n < sizeof(c->text) - c->len) c->len += (size_t)n; // the live system may have more
+    c->count++;
+    return 0;
+}
+
+/**
+ * @brief ifshow_write_fn appending to a `struct outbuf`.
+ */
+static int append(const void *data, size_t len, void *arg) {
+    out_write(arg, data, len);
+    return 0;
+}
+
+/**
+ * @brief The public API over a decoded document: interfaces, iteration, owners and formatting.
+ */
+static void test_public_decode(void) {
+    struct snapshot s = {0};
+    bin_fixture(&s);
+    size_t len;
+    unsigned char *doc = (unsigned char *)render(&s, FORMAT_BIN, 1, &len);
+    CHECK(ifshow_snapshot_decode(doc, len - 1) == NULL);
+    struct ifshow_snapshot *api = ifshow_snapshot_decode(doc, len);
+    CHECK(api != NULL);
+    if (!api) return;
+    CHECK(ifshow_snapshot_interface_count(api) == 4);
+    CHECK_STR(ifshow_snapshot_interface(api, 1), "wan0");
+    CHECK(ifshow_snapshot_interface(api, 4) == NULL);
+
+    struct collected c = {0};
+    CHECK(ifshow_snapshot_foreach(api, "eth0", collect, &c) == 3);
+    CHECK_STR(c.text, "eth0 192.0.2.10/24;eth0 fe80::1/64;eth0 10.1.2.3/-2;");
+    CHECK(ifshow_snapshot_foreach(api, "wan0", collect, &c) == 0);
+
+    struct ifshow_addr owner;
+    CHECK(ifshow_snapshot_owner(api, "192.0.2.99", &owner) == 1 && strcmp(owner.ifname, "eth0") == 0);
+    CHECK(ifshow_snapshot_owner(api, "127.0.0.1", &owner) == 1 && strcmp(owner.ifname, "lo") == 0);
+    CHECK(ifshow_snapshot_owner(api, "203.0.113.1", &owner) == 0);
+    CHECK(ifshow_snapshot_owner(api, "not-an-ip", &owner) == -1);
+
+    struct outbuf ob = { .fd = -1 };
+    CHECK(ifshow_snapshot_format(api, IFSHOW_FORMAT_TEXT, append, &ob) == 0);
+    out_write(&ob, "", 1);
+    char *want = render(&s, FORMAT_TEXT, 1, NULL);
+    CHECK_STR(ob.data, want);
+    free(want);
+    free(ob.data);
+    CHECK(ifshow_snapshot_format(api, (enum ifshow_format)99, append, &ob) == -1);
+    ifshow_snapshot_free(api);
+    snapshot_free(&s);
+    free(doc);
+}
+
+/**
+ * @brief The public API on the live system: a snapshot owns each of its own addresses.
+ */
+static void test_public_live(void) {
+    struct ifshow_ctx *ctx = ifshow_open(IFSHOW_BACKEND_DEFAULT);
+    CHECK(ctx != NULL);
+    if (!ctx) return;
+    struct ifshow_request req = { .sort = IFSHOW_SORT_NAME };
+    struct ifshow_snapshot *s = ifshow_snapshot_take(ctx, &req);
+    CHECK(s != NULL);
+    size_t total = 0;
+    struct collected all = {0};
+    for (size_t i = 0; s && i < ifshow_snapshot_interface_count(s); ++i) {
+        total += ifshow_snapshot_foreach(s, ifshow_snapshot_interface(s, i), collect, &all);
+    }
+    CHECK(!s || ifshow_snapshot_foreach(s, NULL, collect, &all) == total);
+    CHECK(all.count == 2 * total);
+    ifshow_snapshot_free(s);
+
+    const char *names[] = { "ifshow-test-missing0" };
+    struct ifshow_request one = { .names = names, .name_count = 1 };
+    s = ifshow_snapshot_take(ctx, &one);
+    CHECK(s && ifshow_snapshot_interface_count(s) == 1 && ifshow_snapshot_foreach(s, names[0], collect, &all) == 0);
+    ifshow_snapshot_free(s);
+    ifshow_close(ctx);
+}
+
+int main(void) {
+    static const struct {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        { "fmt_ipv4", test_fmt_ipv4 },
+        { "fmt_ipv6", test_fmt_ipv6 },
+        { "prefix_length", test_prefix_length },
+        { "filter_net", test_filter_net },
+        { "glob", test_glob },
+        { "intern", test_intern },
+        { "group", test_group },
+        { "sort", test_sort },
+        { "owner_trie", test_owner_trie },
+        { "count", test_count },
+        { "summarize_siblings", test_summarize_siblings },
+        { "summarize_keeps", test_summarize_keeps },
+        { "link_flags", test_link_flags },
+        { "bin_round_trip", test_bin_round_trip },
+        { "bin_corrupt", test_bin_corrupt },
+        { "public_decode", test_public_decode },
+        { "public_live", test_public_live },
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        int before = failures;
+        tests[i].run();
+        printf("%s %s\n", failures == before ? "ok  " : "FAIL", tests[i].name);
+    }
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
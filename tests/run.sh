@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+# run.sh - Build libifshow.a, ifshow and the unit tests, then run both test suites.
+# FR: run.sh - Compile libifshow.a, ifshow et les tests unitaires, puis lance les deux suites de tests.
+#
+# Usage / Utilisation:
+# - sh tests/run.sh. EN: From anywhere; builds in the repository root with $CC (default gcc) and $CFLAGS.
+#   FR: Depuis n'importe où ; compile à la racine du dépôt avec $CC (gcc par défaut) et $CFLAGS.
+
+set -e
+cd "$(dirname "$0")/.."
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--Wall -Wextra -O2}
+
+$CC $CFLAGS -c -o libifshow.o libifshow.c
+ar rcs libifshow.a libifshow.o
+$CC $CFLAGS -pthread -o ifshow ifshow.c libifshow.a
+$CC $CFLAGS -o tests/ifshow_test tests/ifshow_test.c libifshow.a
+
+./tests/ifshow_test
+sh tests/cli_test.sh ./ifshow